@@ -0,0 +1,142 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* NOTE: [Improve] Local APIC 드라이버.
+   CPU마다 하나씩 있는 Local APIC로 CPU 간 인터럽트(IPI)를 보내고,
+   AP를 깨우는 INIT/STARTUP 신호를 보낸다.
+   외부 장치 인터럽트는 여전히 8259A PIC가 BSP의 LINT0으로 전달하므로
+   (BIOS가 설정한 virtual wire 모드) 여기서는 건드리지 않는다.
+   See [IA32-v3a] chapter 10 "Advanced Programmable Interrupt Controller". */
+
+#define MSR_APIC_BASE 0x1b			 /* Local APIC 물리 주소가 담긴 MSR. */
+#define APIC_BASE_ENABLE (1 << 11)	 /* MSR_APIC_BASE: APIC 전역 활성화. */
+#define APIC_BASE_ADDR 0x000ffffffffff000ULL /* MSR_APIC_BASE: 물리 주소 (52비트). */
+
+/* Local APIC 레지스터 오프셋 (바이트). */
+#define LAPIC_ID 0x020		 /* Local APIC ID. */
+#define LAPIC_TPR 0x080		 /* Task Priority. */
+#define LAPIC_EOI 0x0b0		 /* End of Interrupt. */
+#define LAPIC_SVR 0x0f0		 /* Spurious Interrupt Vector. */
+#define LAPIC_ICR_LO 0x300	 /* Interrupt Command (하위 32비트). */
+#define LAPIC_ICR_HI 0x310	 /* Interrupt Command (상위 32비트). */
+
+#define SVR_ENABLE 0x100	 /* SVR: APIC 소프트웨어 활성화. */
+
+/* ICR 필드. */
+#define ICR_FIXED 0x00000
+#define ICR_INIT 0x00500
+#define ICR_STARTUP 0x00600
+#define ICR_PENDING 0x01000	  /* 전송 중. */
+#define ICR_ASSERT 0x04000
+#define ICR_LEVEL 0x08000
+#define ICR_ALL_BUT_SELF 0xc0000
+
+/* Local APIC 레지스터가 매핑된 커널 가상 주소. NULL이면 아직 초기화 전. */
+static volatile uint32_t *lapic;
+
+static uint32_t
+lapic_read(int reg)
+{
+	return lapic[reg / sizeof(uint32_t)];
+}
+
+static void
+lapic_write(int reg, uint32_t value)
+{
+	lapic[reg / sizeof(uint32_t)] = value;
+	(void)lapic_read(LAPIC_ID); /* 쓰기가 끝날 때까지 기다림 */
+}
+
+/* 앞서 보낸 IPI가 전달될 때까지 기다린다. */
+static void
+lapic_wait_icr(void)
+{
+	while (lapic_read(LAPIC_ICR_LO) & ICR_PENDING)
+		cpu_relax();
+}
+
+static void
+lapic_write_icr(uint32_t dest, uint32_t cmd)
+{
+	lapic_wait_icr();
+	lapic_write(LAPIC_ICR_HI, dest << 24);
+	lapic_write(LAPIC_ICR_LO, cmd);
+}
+
+/* 현재 CPU의 Local APIC를 켠다.
+   처음 호출될 때(BSP) 레지스터 페이지를 캐시하지 않도록 커널 페이지 테이블에
+   매핑한다.  커널 영역 매핑은 모든 프로세스의 pml4가 공유한다. */
+void lapic_init(void)
+{
+	uint64_t base = read_msr(MSR_APIC_BASE);
+
+	if (lapic == NULL)
+	{
+		uint64_t pa = base & APIC_BASE_ADDR;
+		uint64_t *pte;
+
+		lapic = ptov(pa);
+		pte = pml4e_walk(base_pml4, (uint64_t)lapic, 1);
+		ASSERT(pte != NULL);
+		*pte = pa | PTE_P | PTE_W | PTE_PCD | PTE_PWT;
+		invlpg((uint64_t)lapic);
+	}
+
+	write_msr(MSR_APIC_BASE, base | APIC_BASE_ENABLE);
+	lapic_write(LAPIC_SVR, SVR_ENABLE | IPI_SPURIOUS);
+	lapic_write(LAPIC_TPR, 0);
+}
+
+/* Local APIC를 쓸 수 있는지 반환한다. */
+bool lapic_enabled(void)
+{
+	return lapic != NULL;
+}
+
+/* 현재 CPU의 Local APIC ID를 반환한다. */
+uint32_t lapic_id(void)
+{
+	return lapic_read(LAPIC_ID) >> 24;
+}
+
+/* Local APIC로 전달된 인터럽트(IPI) 처리가 끝났음을 알린다. */
+void lapic_eoi(void)
+{
+	lapic_write(LAPIC_EOI, 0);
+}
+
+/* APIC_ID인 CPU에 VEC 인터럽트를 보낸다. */
+void lapic_send_ipi(uint32_t apic_id, uint8_t vec)
+{
+	lapic_write_icr(apic_id, ICR_FIXED | vec);
+}
+
+/* 자신을 뺀 모든 CPU에 VEC 인터럽트를 보낸다. */
+void lapic_broadcast_ipi(uint8_t vec)
+{
+	lapic_write_icr(0, ICR_ALL_BUT_SELF | ICR_FIXED | vec);
+}
+
+/* 자신을 뺀 모든 CPU에 INIT-SIPI-SIPI를 보내 물리 주소 ENTRY_PA에서
+   real mode로 시작하게 한다.  See [IA32-v3a] 8.4.4 "MP Initialization
+   Example". */
+void lapic_start_aps(uint64_t entry_pa)
+{
+	ASSERT(entry_pa < 0x100000 && entry_pa % PGSIZE == 0);
+
+	lapic_write_icr(0, ICR_ALL_BUT_SELF | ICR_INIT | ICR_ASSERT | ICR_LEVEL);
+	timer_msleep(10);
+	for (int i = 0; i < 2; i++)
+	{
+		lapic_write_icr(0, ICR_ALL_BUT_SELF | ICR_STARTUP | (entry_pa >> 12));
+		timer_usleep(200);
+	}
+	lapic_wait_icr();
+}
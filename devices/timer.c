@@ -7,6 +7,8 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/cpu.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,14 +19,39 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency and the counter value for one tick. */
+#define PIT_HZ 1193180
+#define PIT_TICK_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* NOTE: [Improve] one-shot 모드로 한 번에 건너뛸 수 있는 최대 tick 수.
+   8254의 카운터가 16비트이므로 65535 / PIT_TICK_COUNT를 넘을 수 없다
+   (TIMER_FREQ 100이면 5 tick). 그래서 idle CPU는 최대 5 tick마다 한 번 깨어난다.
+   더 길게 재우려면 Local APIC 타이머(32비트 카운터)를 PIT로 보정해서 써야 하는데,
+   지금 lapic.c는 IPI만 다루고 타이머는 없으므로 하지 않았다. */
+#define ONESHOT_MAX_TICKS (0xffff / PIT_TICK_COUNT)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* NOTE: [Improve] -idle-oneshot 옵션: idle일 때 타이머 인터럽트 몇 개를 하나로 묶음 */
+bool timer_idle_oneshot;
+
+/* NOTE: [Improve] 현재 one-shot으로 예약된 tick 수 (0이면 주기 모드) */
+static int oneshot_ticks;
+
+/* NOTE: [Improve] 타이머 인터럽트 핸들러 비용 통계 (rdtsc cycle 단위) */
+static int64_t intr_count;
+static uint64_t intr_cycles_total;
+static uint64_t intr_cycles_max;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
 static intr_handler_func timer_interrupt;
+static intr_handler_func timer_ipi_interrupt;
+static void timer_program_periodic(void);
+static void timer_program_oneshot(int tick_cnt);
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
@@ -37,16 +64,108 @@ static void real_time_sleep(int64_t num, int32_t denom);
  * 이 함수는 8254 타이머 인터럽트를 처리하는 데 필요한 초기 설정을 수행합니다.
  */
 void timer_init(void)
+{
+	timer_program_periodic();
+
+	intr_register_ext(0x20, timer_interrupt, "8254 Timer"); /* 인터럽트 핸들러 등록 */
+	intr_register_ipi(IPI_TIMER_TICK, timer_ipi_interrupt, "Timer tick IPI"); /* NOTE: [Improve] AP용 tick */
+}
+
+/* Programs the 8254 to interrupt TIMER_FREQ times per second. */
+static void
+timer_program_periodic(void)
 {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	uint16_t count = PIT_TICK_COUNT;
 
 	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb(0x40, count & 0xff);
 	outb(0x40, count >> 8);
+}
 
-	intr_register_ext(0x20, timer_interrupt, "8254 Timer"); /* 인터럽트 핸들러 등록 */
+/* NOTE: [Improve] Programs the 8254 to interrupt once, TICK_CNT
+   ticks from now, and then stay quiet until reprogrammed. */
+static void
+timer_program_oneshot(int tick_cnt)
+{
+	uint16_t count = tick_cnt * PIT_TICK_COUNT;
+
+	ASSERT(0 < tick_cnt && tick_cnt <= ONESHOT_MAX_TICKS);
+
+	outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb(0x40, count & 0xff);
+	outb(0x40, count >> 8);
+}
+
+/** NOTE: [Improve]
+ * @brief idle 쓰레드가 hlt 하기 직전에 호출되어, 다음 타이머 인터럽트를 뒤로 미룹니다.
+ *
+ * tickless가 아니다: -idle-oneshot 옵션이 켜진 단일 CPU에서만, 가장 이른 sleeper의
+ * wakeup_tick (타이밍 휠의 다음 cascade 시점 포함)까지 PIT를 one-shot 모드로
+ * 예약하며 그 길이는 ONESHOT_MAX_TICKS (5 tick)를 넘지 못합니다. 즉 idle 중
+ * 인터럽트 수를 최대 1/5로 줄일 뿐입니다. 다음 1초 경계도 넘지 않도록 해서
+ * MLFQS의 load_avg 갱신 시점이 빠지지 않게 합니다.
+ * 인터럽트가 꺼진 상태에서 호출되어야 합니다.
+ */
+void timer_idle_enter(void)
+{
+	int64_t limit, delta;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!timer_idle_oneshot || oneshot_ticks != 0) /* 이미 예약돼 있으면 그대로 둠 */
+		return;
+
+	/* NOTE: [Improve] SMP에서는 AP들의 tick도 BSP의 PIT가 IPI로 전달하므로 멈추지 않음.
+	   CPU마다 따로 재우려면 CPU별 Local APIC 타이머가 필요하다 (위 ONESHOT_MAX_TICKS 참고) */
+	if (cpu_cnt > 1 || this_cpu()->id != 0)
+		return;
+
+	limit = ONESHOT_MAX_TICKS;
+	if (TIMER_FREQ - ticks % TIMER_FREQ < limit)
+		limit = TIMER_FREQ - ticks % TIMER_FREQ;
+
+	delta = thread_next_wakeup(ticks + limit) - ticks;
+	if (delta <= 1) /* 바로 다음 tick에 할 일이 있으면 주기 모드 유지 */
+		return;
+
+	oneshot_ticks = delta;
+	timer_program_oneshot(oneshot_ticks);
+}
+
+/** NOTE: [Improve]
+ * @brief one-shot이 만료되기 전에 idle을 벗어날 때 호출되어 주기 모드로 되돌립니다.
+ *
+ * 그동안 지나간 tick을 PIT 카운터에서 읽어 ticks와 idle_ticks에 반영합니다.
+ * 만료 직전이라 아직 처리되지 않은 인터럽트가 있다면 그 인터럽트가 마지막 tick을 센다.
+ */
+void timer_idle_exit(void)
+{
+	int total, remaining, elapsed;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (oneshot_ticks == 0)
+		return;
+
+	outb(0x43, 0x00); /* CW: counter 0, latch count. */
+	remaining = inb(0x40);
+	remaining |= inb(0x40) << 8;
+
+	total = oneshot_ticks * PIT_TICK_COUNT;
+	if (remaining > total) /* 이미 0을 지나 wrap됨: 대기 중인 인터럽트가 마지막 tick */
+		elapsed = oneshot_ticks - 1;
+	else
+		elapsed = (total - remaining) / PIT_TICK_COUNT;
+	if (elapsed > oneshot_ticks - 1)
+		elapsed = oneshot_ticks - 1;
+
+	oneshot_ticks = 0;
+	timer_program_periodic();
+
+	ticks += elapsed;
+	thread_add_idle_ticks(elapsed);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -150,6 +269,34 @@ void timer_print_stats(void)
 	printf("Timer: %" PRId64 " ticks\n", timer_ticks());
 }
 
+/** NOTE: [Improve]
+ * @brief 타이머 인터럽트 핸들러 비용 통계를 초기화합니다.
+ */
+void timer_intr_stats_reset(void)
+{
+	enum intr_level old_level = intr_disable();
+	intr_count = 0;
+	intr_cycles_total = 0;
+	intr_cycles_max = 0;
+	intr_set_level(old_level);
+}
+
+/** NOTE: [Improve]
+ * @brief 마지막 초기화 이후 타이머 인터럽트 핸들러가 걸린 시간을 돌려줍니다.
+ *
+ * @param count 측정된 인터럽트 수
+ * @param avg_cycles 인터럽트 한 번당 평균 cycle 수
+ * @param max_cycles 가장 오래 걸린 인터럽트의 cycle 수
+ */
+void timer_intr_stats(int64_t *count, uint64_t *avg_cycles, uint64_t *max_cycles)
+{
+	enum intr_level old_level = intr_disable();
+	*count = intr_count;
+	*avg_cycles = intr_count > 0 ? intr_cycles_total / intr_count : 0;
+	*max_cycles = intr_cycles_max;
+	intr_set_level(old_level);
+}
+
 /* Timer interrupt handler. */
 
 /**
@@ -160,26 +307,61 @@ void timer_print_stats(void)
 static void
 timer_interrupt(struct intr_frame *args UNUSED)
 {
+	uint64_t start = rdtsc();
+	uint64_t cycles;
+
+	/* NOTE: [Improve] one-shot이 만료됐다면 idle 동안 건너뛴 tick을 반영하고 주기 모드로 복귀 */
+	if (oneshot_ticks != 0)
+	{
+		ticks += oneshot_ticks - 1;
+		thread_add_idle_ticks(oneshot_ticks - 1);
+		oneshot_ticks = 0;
+		timer_program_periodic();
+	}
+
 	ticks++;
 	thread_tick();
 	if (thread_mlfqs)
 	{
 		mlfqs_increase_recent_cpu();
-		if (ticks % 4 == 0)
+		/* NOTE: [Improve] 1초마다 실행 가능한 쓰레드 전체를, 그 사이 4 tick마다 실행 중인 쓰레드만 재계산 */
+		if (timer_ticks() % TIMER_FREQ == 0) /* ticks % 100 == 0*/
 		{
-			mlfqs_recalculate_priority();
-			if (timer_ticks() % TIMER_FREQ == 0) /* ticks % 100 == 0*/
-			{
-				mlfqs_calculate_load_avg();
-				mlfqs_recalculate_recent_cpu();
-			}
+			mlfqs_calculate_load_avg();
+			mlfqs_recalculate_recent_cpu();
 		}
+		else if (ticks % 4 == 0)
+			mlfqs_recalculate_priority();
 	}
 
-	if (get_min_tick() <= ticks)
-	{
-		thread_wakeup(ticks); /* 지정된 틱 시간에 깨어날 스레드를 깨우는 함수 호출 */
-	}
+	thread_wakeup(ticks); /* 지정된 틱 시간에 깨어날 스레드를 깨우는 함수 호출 (O(1)) */
+
+	/* NOTE: [Improve] 주기적으로 CPU 간 부하를 맞춤 */
+	if (cpu_cnt > 1 && ticks % BALANCE_INTERVAL == 0)
+		thread_balance();
+
+	/* NOTE: [Improve] PIT 인터럽트는 BSP에만 오므로 다른 CPU들에게 tick을 전달 */
+	if (cpu_cnt > 1)
+		cpu_broadcast_ipi(IPI_TIMER_TICK);
+
+	cycles = rdtsc() - start;
+	intr_count++;
+	intr_cycles_total += cycles;
+	if (cycles > intr_cycles_max)
+		intr_cycles_max = cycles;
+}
+
+/** NOTE: [Improve]
+ * @brief BSP가 보낸 tick IPI 핸들러. AP에서 실행 중인 쓰레드의 time slice와 recent_cpu를 갱신한다.
+ *
+ * 전역 ticks, 타이밍 휠, MLFQS 주기 재계산은 BSP의 timer_interrupt()가 담당한다.
+ */
+static void
+timer_ipi_interrupt(struct intr_frame *args UNUSED)
+{
+	thread_tick();
+	if (thread_mlfqs)
+		mlfqs_increase_recent_cpu();
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -0,0 +1,15 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void lapic_init (void);
+bool lapic_enabled (void);
+uint32_t lapic_id (void);
+void lapic_eoi (void);
+void lapic_send_ipi (uint32_t apic_id, uint8_t vec);
+void lapic_broadcast_ipi (uint8_t vec);
+void lapic_start_aps (uint64_t entry_pa);
+
+#endif /* devices/lapic.h */
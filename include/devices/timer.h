@@ -2,13 +2,21 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* If true, an idle uniprocessor stretches the next 8254 interrupt
+   over up to a few ticks instead of taking every one.
+   Controlled by kernel command-line option "-idle-oneshot". */
+extern bool timer_idle_oneshot;
+
 void timer_init (void);
 void timer_calibrate (void);
+void timer_idle_enter (void);
+void timer_idle_exit (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
@@ -20,4 +28,8 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+void timer_intr_stats_reset (void);
+void timer_intr_stats (int64_t *count, uint64_t *avg_cycles,
+                       uint64_t *max_cycles);
+
 #endif /* devices/timer.h */
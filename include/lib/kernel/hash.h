@@ -54,6 +54,12 @@ typedef bool hash_less_func (const struct hash_elem *a,
  * data AUX. */
 typedef void hash_action_func (struct hash_elem *e, void *aux);
 
+/* Returns true if hash element E matches KEY, given auxiliary
+ * data AUX.  Used to search a table without building a whole
+ * element just to hold the key. */
+typedef bool hash_key_func (const struct hash_elem *e, const void *key,
+		void *aux);
+
 /* Hash table. */
 struct hash {
 	size_t elem_cnt;            /* Number of elements in table. */
@@ -80,6 +86,8 @@ void hash_destroy (struct hash *, hash_action_func *);
 struct hash_elem *hash_insert (struct hash *, struct hash_elem *);
 struct hash_elem *hash_replace (struct hash *, struct hash_elem *);
 struct hash_elem *hash_find (struct hash *, struct hash_elem *);
+struct hash_elem *hash_find_key (struct hash *, uint64_t hash,
+		hash_key_func *, const void *key);
 struct hash_elem *hash_delete (struct hash *, struct hash_elem *);
 
 /* Iteration. */
@@ -36,6 +36,9 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_GET_PHYS_ADDR,          /* Physical address backing a user address. */
 };
 
 #endif /* lib/syscall-nr.h */
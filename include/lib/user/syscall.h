@@ -1,20 +1,24 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 #include <stdbool.h>
+#include <stddef.h>
 #include "threads/synch.h"
 #include "threads/thread.h"
 
 typedef int pid_t;
-typedef int off_t;
+#define PID_ERROR ((pid_t) -1)
+
+/* Maximum characters in a filename written by readdir(). */
+#define READDIR_MAX_LEN 14
 
-struct lock filesys_lock; /* 파일 접근 시 필요한 락 */
+typedef int off_t;
 
 void syscall_init(void);
 void syscall_entry(void);
 void check_address(void *addr);
 void halt(void);
 void exit(int status);
-pid_t fork(const char *thread_name, struct intr_frame *f);
+pid_t fork(const char *thread_name);
 int exec(const char *file);
 int wait(pid_t pid);
 bool create(const char *file, unsigned initial_size);
@@ -27,4 +31,11 @@ void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
 
+/* Project 3 */
+#define MAP_FAILED ((void *) NULL)
+
+void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
+void munmap(void *addr);
+void *get_phys_addr(void *user_addr);
+
 #endif /* userprog/syscall.h */
@@ -0,0 +1,96 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+/* NOTE: [Improve] SMP 지원을 위한 CPU별 데이터.
+
+   각 CPU는 struct cpu 하나를 가지며, 그 주소를 GS base MSR에 넣어둔다.
+   커널 안에서는 %gs:0 (self 포인터)만 읽으면 현재 CPU를 알 수 있다.
+   유저 모드로 돌아갈 때와 유저 모드에서 들어올 때는 swapgs로
+   커널/유저 GS base를 바꾼다.
+
+   아래 CPU_* 오프셋은 어셈블리(intr-stubs.S, syscall-entry.S)에서
+   쓰이므로 struct cpu 앞부분의 배치를 바꾸면 함께 고쳐야 한다. */
+
+#define CPU_MAX 8		/* 지원하는 최대 CPU 수. */
+#define CPU_SELF 0		/* offsetof (struct cpu, self) */
+#define CPU_TSS 8		/* offsetof (struct cpu, tss) */
+#define CPU_SCRATCH 16	/* offsetof (struct cpu, scratch) */
+
+#define MSR_GS_BASE 0xc0000101		  /* 현재 GS base. */
+#define MSR_KERNEL_GS_BASE 0xc0000102 /* swapgs로 바꿔 넣을 GS base. */
+
+/* AP 부팅 코드(start.S의 ap_trampoline)를 복사해 둘 물리 주소.
+   SIPI 벡터로 쓰이므로 1MB 아래의 페이지 경계여야 한다. */
+#define AP_TRAMPOLINE 0x8000
+
+/* CPU 간 인터럽트(IPI) 벡터. */
+#define IPI_RESCHEDULE 0xf0		 /* 스케줄링을 다시 해보라는 요청. */
+#define IPI_TIMER_TICK 0xf1		 /* BSP의 타이머 tick을 AP에 전달. */
+#define IPI_TLB_SHOOTDOWN 0xf2	 /* TLB를 비우라는 요청. */
+#define IPI_SPURIOUS 0xff		 /* Local APIC spurious 인터럽트. */
+
+#ifndef __ASSEMBLER__
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+struct task_state;
+
+struct cpu
+{
+	/* 어셈블리에서 접근하는 필드 (위의 CPU_* 오프셋과 일치해야 함). */
+	struct cpu *self;		 /* 자기 자신. this_cpu()가 %gs:0에서 읽음 */
+	struct task_state *tss;	 /* 이 CPU의 TSS (USERPROG) */
+	uint64_t scratch[2];	 /* syscall_entry의 임시 레지스터 저장소 */
+
+	int id;					 /* 0 = BSP, 1.. = AP 부팅 순서 */
+	uint32_t lapic_id;		 /* Local APIC ID (IPI 목적지) */
+	bool online;			 /* 부팅을 마치고 스케줄링에 참여 중인지 */
+
+	struct thread *idle_thread; /* 이 CPU의 idle 쓰레드 */
+	struct thread *curr;		/* 이 CPU에서 실행 중인 쓰레드 */
+	uint64_t *pml4;				/* 이 CPU의 CR3에 올라가 있는 페이지 테이블 */
+	unsigned thread_ticks;		/* 마지막 yield 이후 지난 tick 수 */
+
+	bool in_external_intr;	/* 외부 인터럽트 처리 중인지 */
+	bool yield_on_return;	/* 인터럽트 복귀 시 yield할지 */
+	bool kernel_locked;		/* 이 CPU가 kernel_lock을 잡고 있는지 */
+	volatile bool tlb_flush_pending; /* 다른 CPU가 TLB flush를 요청했는지 */
+
+	struct thread *fpu_owner; /* FPU 레지스터에 상태가 올라가 있는 쓰레드 */
+} __attribute__((aligned(64)));
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;
+
+/* 현재 CPU의 struct cpu를 반환한다.
+   쓰레드가 다른 CPU로 옮겨갈 수 있으므로, 인터럽트를 끈 상태가
+   아니라면 반환값은 곧 틀린 값이 될 수 있다. */
+static inline struct cpu *
+this_cpu(void)
+{
+	struct cpu *c;
+	__asm __volatile("movq %%gs:0, %0" : "=r"(c));
+	return c;
+}
+
+void cpu_init_bsp(void);
+void cpu_start_aps(void);
+void ap_main(int id);
+
+void cpu_send_ipi(struct cpu *, uint8_t vec);
+void cpu_broadcast_ipi(uint8_t vec);
+void cpu_tlb_invalidate(uint64_t *pml4, const void *va);
+
+/* Big kernel lock.
+   커널 코드는 한 번에 한 CPU에서만 실행된다.  유저 모드 코드와 idle 상태의
+   CPU만 동시에 돌아가므로, 인터럽트를 끄는 기존의 임계 구역은 그대로 안전하다.
+   lock은 쓰레드가 아니라 CPU가 잡고 있으며, 유저 모드로 돌아갈 때와
+   idle CPU가 hlt하기 직전에만 놓는다. */
+void kernel_lock_acquire(void);
+void kernel_lock_release(void);
+bool kernel_lock_held(void);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* threads/cpu.h */
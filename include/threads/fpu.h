@@ -0,0 +1,18 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+/* NOTE: [Improve] FXSAVE 영역의 크기와 정렬 */
+#define FPU_AREA_SIZE 512
+#define FPU_AREA_ALIGN 16
+
+void fpu_init(void);
+void fpu_init_cpu(void);
+void fpu_switch(struct thread *curr);
+bool fpu_copy(struct thread *dst, const struct thread *src);
+void fpu_release(void);
+
+#endif /* threads/fpu.h */
@@ -69,8 +69,13 @@ struct intr_frame
 
 typedef void intr_handler_func(struct intr_frame *);
 
+/* NOTE: [Improve] CPU 간 인터럽트(IPI)에 쓰는 첫 벡터 (threads/cpu.h 참고) */
+#define INTR_IPI_BASE 0xf0
+
 void intr_init(void);
+void intr_init_ap(void);
 void intr_register_ext(uint8_t vec, intr_handler_func *, const char *name);
+void intr_register_ipi(uint8_t vec, intr_handler_func *, const char *name);
 void intr_register_int(uint8_t vec, int dpl, enum intr_level,
 					   intr_handler_func *, const char *name);
 bool intr_context(void);
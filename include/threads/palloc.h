@@ -19,5 +19,10 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_drain_caches (void);
+void palloc_start_zeroer (void);
+void palloc_print_stats (void);
+size_t palloc_user_page_cnt (void);
+size_t palloc_user_page_idx (void *);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,38 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+#include <list.h>
+#include "threads/synch.h"
+
+/* NOTE: [Improve] Slab cache.
+   같은 크기의 커널 객체를 페이지 단위 slab에 빽빽하게 담아 관리한다.
+   malloc()은 요청 크기를 2의 거듭제곱으로 올려 버리지만, slab cache는
+   객체 크기(8바이트 정렬)만큼만 쓰므로 자주 만드는 구조체의 낭비가 적다.
+   각 slab은 비트맵으로 빈 칸을 기억하고, 상태에 따라 partial/full/empty
+   리스트 중 하나에 들어간다. */
+struct kmem_cache
+{
+	const char *name;		  /* 디버깅용 이름 */
+	size_t obj_size;		  /* 객체 하나의 크기 (8바이트 정렬) */
+	size_t objs_per_slab;	  /* slab 하나에 들어가는 객체 수 */
+	size_t obj_ofs;			  /* slab 페이지 안에서 첫 객체의 위치 */
+	void (*ctor)(void *);	  /* 객체 생성자, 없으면 NULL */
+
+	struct list slabs_partial; /* 빈 칸과 쓰는 칸이 섞인 slab */
+	struct list slabs_full;	   /* 빈 칸이 없는 slab */
+	struct list slabs_empty;   /* 모두 빈 slab */
+	size_t empty_cnt;		   /* slabs_empty의 길이 */
+	size_t slab_cnt;		   /* 가지고 있는 slab(페이지) 수 */
+	size_t active_cnt;		   /* 사용 중인 객체 수 */
+
+	struct lock lock;
+};
+
+struct kmem_cache *kmem_cache_create(const char *name, size_t size,
+									 void (*ctor)(void *));
+void kmem_cache_destroy(struct kmem_cache *);
+void *kmem_cache_alloc(struct kmem_cache *);
+void kmem_cache_free(struct kmem_cache *, void *);
+
+#endif /* threads/slab.h */
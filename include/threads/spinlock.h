@@ -0,0 +1,27 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+struct cpu;
+
+/* NOTE: [Improve] Spinlock.
+   여러 CPU가 동시에 접근하는 짧은 임계 구역을 보호한다.
+   잡고 있는 동안에는 인터럽트를 끄므로, 같은 CPU의 인터럽트 핸들러와도
+   배타적이다.  잡은 채로 잠들면(thread_block) 안 된다. */
+struct spinlock
+{
+	volatile int locked;	   /* 1이면 누군가 잡고 있음 */
+	struct cpu *holder;		   /* 잡고 있는 CPU (디버깅용) */
+	enum intr_level old_level; /* spin_lock() 이전의 인터럽트 상태 */
+	const char *name;		   /* 디버깅용 이름 */
+};
+
+void spin_lock_init(struct spinlock *, const char *name);
+void spin_lock(struct spinlock *);
+bool spin_trylock(struct spinlock *);
+void spin_unlock(struct spinlock *);
+bool spin_lock_held(const struct spinlock *);
+
+#endif /* threads/spinlock.h */
@@ -0,0 +1,18 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+struct intr_frame;
+
+/* Saves the running thread's callee-saved registers on its stack,
+   stores its stack pointer into *CUR_KSP, and resumes the thread
+   whose saved stack pointer is NEXT_KSP.  A NEXT_KSP of 0 means the
+   next thread has never run (or was last saved into its intr_frame),
+   so it is launched from NEXT_TF with do_iret() instead. */
+void switch_threads (uint64_t *cur_ksp, uint64_t next_ksp,
+                     struct intr_frame *next_tf);
+#endif
+
+#endif /* threads/switch.h */
@@ -44,6 +44,7 @@ void cond_broadcast(struct condition *, struct lock *); /* cond를 기다리는
 
 bool cmp_condition(struct list_elem *a, struct list_elem *b, void *aux);
 bool cmp_donation(struct list_elem *a, struct list_elem *b, void *aux);
+void donate_priority(void);
 void remove_donations(struct lock *lock);
 void update_donate_priority(void);
 /* Optimization barrier.
@@ -109,7 +109,23 @@ struct thread
 
 	/* NOTE: [Part3] MLFQ를 위한 데이터 추가 - nice, recent_cpu */
 	int nice;			/* 쓰레드의 친절함을 나타내는 지표 */
-	int32_t recent_cpu; /* 쓰레드의 최근 CPU 사용량을 나타내는 지표 */
+	fixed_point recent_cpu; /* 쓰레드의 최근 CPU 사용량을 나타내는 지표 */
+	int64_t recent_cpu_epoch; /* recent_cpu에 반영된 마지막 decay epoch (thread.c 참고) */
+	bool background;			  /* load_avg에 세지 않는 쓰레드 (thread_set_background()) */
+
+	/* NOTE: [Improve] SMP: 이 쓰레드의 run queue가 있는 (마지막으로 실행된) CPU */
+	int cpu;
+	int64_t last_run; /* 마지막으로 CPU를 내놓은 tick (cache-hot 판단용) */
+
+	/* NOTE: [Improve] switch_threads()가 저장한 커널 스택 포인터.
+	   0이면 아직 실행된 적이 없거나 tf에 저장된 쓰레드라서 do_iret()으로 재개한다. */
+	uint64_t ksp;
+
+	/* NOTE: [Improve] lazy FPU: FXSAVE 영역 (처음 FPU를 쓸 때 할당) */
+	void *fpu_area; /* malloc()으로 받은 원래 주소 */
+	uint8_t *fpu;	/* 16바이트 정렬된 FXSAVE 영역 */
+	int fpu_cpu;	/* 마지막으로 FPU 상태를 올린 CPU (-1이면 없음) */
+	bool fpu_used;	/* 이번 time slice에 FPU를 썼는지 (TS가 꺼져 있음) */
 
 	/* NOTE: [Improve] all_list element */
 	struct list_elem all_elem;
@@ -152,10 +168,21 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* NOTE: [Improve] If true, use the full intr_frame context switch
+   instead of switch_threads().  For benchmarking only. */
+extern bool thread_iret_switch;
+
 void thread_init(void);
+void thread_init_ap(void);
 void thread_start(void);
+void thread_run_idle(void) NO_RETURN;
+
+/* NOTE: [Improve] CPU 간 부하 분산 주기 (tick) */
+#define BALANCE_INTERVAL 20
+void thread_balance(void);
 
 void thread_tick(void);
+void thread_add_idle_ticks(int64_t cnt);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
@@ -173,21 +200,24 @@ void thread_compare_yield(void);
 void thread_yield(void);
 void thread_sleep(int64_t wakeup_tick);
 void thread_wakeup(int64_t curr_tick);
+int64_t thread_next_wakeup(int64_t limit);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_change_priority(struct thread *t, int priority);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
+void thread_set_background(void);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
 void thread_calc_priority(struct thread *t);
 void thread_calc_recent_cpu(struct thread *t);
-void thread_incr_recent_cpu(void);
-void calc_load_avg(void);
-void thread_all_calc_priority(void);
-void thread_all_calc_recent_cpu(void);
+void mlfqs_increase_recent_cpu(void);
+void mlfqs_calculate_load_avg(void);
+void mlfqs_recalculate_priority(void);
+void mlfqs_recalculate_recent_cpu(void);
 
 // static cmp_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux);
 
@@ -9,6 +9,7 @@ typedef int off_t;
 struct lock filesys_lock; /* 파일 접근 시 필요한 락 */
 
 void syscall_init(void);
+void syscall_init_cpu(void);
 void syscall_entry(void);
 void check_address(void *addr);
 void halt(void);
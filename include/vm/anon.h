@@ -2,15 +2,24 @@
 #define VM_ANON_H
 #include "vm/vm.h"
 struct page;
+struct frame;
 enum vm_type;
 
 struct anon_page
 {
     /* anon_page가 swap out될 때 해당 페이지가 swap_disk에 저장되는 slot 번호 */
     uint32_t slot_num;
+    bool prefetch; /* NOTE: [Improve] swap readahead로 읽는 중 (anon.c 참고) */
 };
 
+/* NOTE: [Improve] swap 되지 않은 페이지의 slot_num */
+#define SWAP_SLOT_NONE ((uint32_t) -1)
+
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+void anon_swap_out_cluster(struct page **pages, size_t cnt);
+void anon_swap_out_shared(struct frame *frame);
+bool anon_read_slot(struct page *page, void *kva);
+void vm_anon_print_stats(void);
 
 #endif
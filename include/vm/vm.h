@@ -30,6 +30,7 @@ enum vm_type
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/vma.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
@@ -50,9 +51,9 @@ struct page
 	struct frame *frame; /* Back reference for frame */
 
 	/* Your implementation */
-	struct hash_elem bucket_elem; /* 해시 테이블 요소 */
 	bool writable;
-	int mapped_page_cnt; /* 매핑에 사용한 총 페이지 수 */
+	struct thread *owner;		  /* NOTE: [Improve] 페이지를 가진 스레드 (퇴거 시 owner의 pml4에서 매핑 해제) */
+	struct list_elem sharer_elem; /* NOTE: [Improve] 공유 프레임의 sharers 리스트 요소 */
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -70,9 +71,20 @@ struct page
 /* The representation of "frame" */
 struct frame
 {
-	void *kva;
-	struct page *page;
-	struct list_elem frame_elem; /* frame table 요소 */
+	void *kva;		   /* NOTE: [Improve] NULL이면 frame table의 빈 칸 */
+	struct page *page; /* NOTE: [Improve] 이 프레임의 주인은 page->owner */
+	int ref_cnt;				 /* NOTE: [Improve] 이 프레임을 매핑한 페이지 수 (copy-on-write) */
+	int pin_cnt;				 /* NOTE: [Improve] 0이 아니면 퇴거하지 않음 (vm_handle_wp()) */
+
+	/* NOTE: [Improve] 읽기 전용 파일 페이지 공유.
+	   inode가 NULL이 아니면 share table에 (inode, ofs)로 등록된 프레임이고,
+	   이 프레임을 매핑한 모든 페이지가 sharers에 들어있다.
+	   fork로 copy-on-write 공유 중인 프레임도 sharers가 비어있지 않으면 마찬가지 */
+	struct inode *inode;		 /* 내용을 읽어 온 파일의 inode */
+	off_t ofs;					 /* 파일 안에서의 위치 */
+	uint32_t read_bytes;		 /* 파일에서 읽은 바이트 수 (나머지는 0) */
+	struct hash_elem share_elem; /* share table 요소 */
+	struct list sharers;		 /* 이 프레임을 매핑한 페이지들 */
 };
 
 /* The function table for page operations.
@@ -98,8 +110,13 @@ struct page_operations
  * All designs up to you for this. */
 struct supplemental_page_table
 {
-	/* 보충 페이지 테이블 = 페이지에 대한 추가 정보를 담아서 관리하도록 = 해시 테이블 자료구조 활용 */
-	struct hash spt_hash;
+	/* 보충 페이지 테이블 = 페이지에 대한 추가 정보를 담아서 관리하도록 */
+	/* NOTE: [Improve] pml4와 같은 모양의 4단계 radix tree (vm.c 참고) */
+	void **root;		  /* 최상위 노드 (512칸), 페이지가 없으면 NULL */
+	size_t page_cnt;	  /* 들어있는 페이지 수 */
+	struct list vmas;	  /* NOTE: [Improve] mmap/ELF 세그먼트 범위 (vma.c 참고) */
+	struct vma *vma_hint; /* 마지막으로 찾은 VMA */
+	struct thread *owner; /* NOTE: [Improve] spt를 가진 스레드, fork 때 부모의 pml4를 찾기 위해 */
 };
 
 #include "threads/thread.h"
@@ -112,38 +129,39 @@ struct page *spt_find_page(struct supplemental_page_table *spt,
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
 
+/* NOTE: [Improve] spt 범위 연산 */
+#define SPT_LEVELS 4
+#define SPT_BITS 9
+#define SPT_ENTRIES (1 << SPT_BITS)
+#define SPT_END ((void *)(1ULL << 48)) /* 사용자 주소 공간 끝 (범위 연산의 END로) */
+
+/* PAGE에 대해 할 일, false를 반환하면 순회를 멈춤 */
+typedef bool spt_action_func(struct page *page, void *aux);
+bool spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux);
+bool spt_insert_range(struct supplemental_page_table *spt, struct page **pages, size_t cnt);
+void spt_remove_range(struct supplemental_page_table *spt, void *start, void *end);
+bool spt_range_empty(struct supplemental_page_table *spt, void *start, void *end);
+
 void vm_init(void);
+void vm_print_stats(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 						 bool write, bool not_present);
 
 #define vm_alloc_page(type, upage, writable) \
-	_initializer((type), (upage), (writable), NULL, NULL)
+	vm_alloc_page_with_initializer((type), (upage), (writable), NULL, NULL)
 bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
 									bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page(struct page *page);
 bool vm_claim_page(void *va);
+void vm_release_frame(struct page *page);
+bool vm_prefetch_page(struct page *page, bool map);
+bool vm_map_cached_page(struct page *page);
+void vm_share_invalidate(struct inode *inode, off_t ofs, off_t size);
 enum vm_type page_get_type(struct page *page);
 
 /* ------------ Project3. 추가 ------------- */
-uint64_t hash_func(const struct hash_elem *e, void *aux);
-bool less_func(const struct hash_elem *a, const struct hash_elem *b, void *aux);
-void hash_page_destroy(struct hash_elem *e, void *aux);
 
-/* swap_disk 속 swap_table(list)을 이루는 slot 구조체 */
-struct slot
-{
-	struct page *page;
-	uint32_t slot_num;
-	struct list_elem swap_elem;
-};
-
-struct list frame_table;
 struct lock frame_table_lock;
 
-struct list swap_table;
-struct lock swap_table_lock;
-
-/* 페이지 교체 정책에서 쓸 변수 */
-struct list_elem *evict_start;
-
 #endif /* VM_VM_H */
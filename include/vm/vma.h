@@ -0,0 +1,46 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <list.h>
+#include "filesys/file.h"
+#include "vm/vm.h"
+
+struct supplemental_page_table;
+
+/* NOTE: [Improve] VMA (virtual memory area).
+   mmap 하나, ELF 세그먼트 하나를 [start, end) 범위 하나로 기록한다.
+   struct page는 이 범위 안에서 페이지 폴트가 났을 때 그 페이지 하나만 만든다 */
+struct vma
+{
+	void *start;		 /* 시작 주소 (페이지 정렬) */
+	void *end;			 /* 끝 주소, 이 주소는 포함하지 않음 (페이지 정렬) */
+	struct file *file;	 /* 내용을 읽어 올 파일, VMA가 따로 연 핸들 */
+	off_t ofs;			 /* start에 대응하는 파일 위치 */
+	uint32_t read_bytes; /* start부터 파일에서 읽을 바이트 수, 나머지는 0 */
+	enum vm_type type;	 /* 폴트 때 만들 페이지 타입 (VM_ANON / VM_FILE) */
+	bool writable;
+	bool mmap;			   /* mmap으로 만든 범위 (munmap 대상) */
+
+	/* NOTE: [Improve] readahead 상태, 페이지 번호는 start부터 센 번호 (vma.c 참고) */
+	size_t ra_prev;	  /* 마지막으로 폴트가 난 페이지 */
+	size_t ra_next;	  /* 마지막으로 미리 읽은 창 바로 뒤 페이지 */
+	size_t ra_window; /* 현재 창 크기 */
+	size_t ra_async;  /* async 창: 창 끝에서 이만큼 앞의 페이지에 닿으면 다음 창을 읽음 */
+	struct list_elem elem; /* spt->vmas 요소, start 순서 */
+};
+
+bool vma_map(struct supplemental_page_table *spt, void *start, size_t length,
+			 struct file *file, off_t ofs, uint32_t read_bytes,
+			 enum vm_type type, bool writable, bool mmap);
+struct vma *vma_find(struct supplemental_page_table *spt, const void *addr);
+bool vma_overlaps(struct supplemental_page_table *spt, void *start, void *end);
+bool vma_fault(struct supplemental_page_table *spt, void *addr, bool write);
+void vma_unmap(struct supplemental_page_table *spt, struct vma *vma);
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src);
+void vma_kill(struct supplemental_page_table *spt);
+void vma_readahead(struct supplemental_page_table *spt, void *upage, bool async);
+void vma_print_stats(void);
+
+/* NOTE: [Improve] fault-around 창 크기 (페이지 수, 1이면 끔), 커널 옵션 -fa=N */
+extern unsigned fault_around_pages;
+
+#endif
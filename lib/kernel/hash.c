@@ -131,6 +131,28 @@ hash_find(struct hash *h, struct hash_elem *e)
 	return find_elem(h, find_bucket(h, e), e);
 }
 
+/* NOTE: [Improve] Finds and returns an element in hash table H
+   that matches KEY according to MATCH, or a null pointer if none
+   does.  HASH must be the value H's hash function would return
+   for an element with that key; it selects the bucket, and only
+   that bucket is searched.  Unlike hash_find(), the caller does
+   not need a whole element to search with. */
+struct hash_elem *
+hash_find_key(struct hash *h, uint64_t hash, hash_key_func *match,
+			  const void *key)
+{
+	struct list *bucket = &h->buckets[hash & (h->bucket_cnt - 1)];
+	struct list_elem *i;
+
+	for (i = list_begin(bucket); i != list_end(bucket); i = list_next(i))
+	{
+		struct hash_elem *hi = list_elem_to_hash_elem(i);
+		if (match(hi, key, h->aux))
+			return hi;
+	}
+	return NULL;
+}
+
 /* Finds, removes, and returns an element equal to E in hash
    table H.  Returns a null pointer if no equal element existed
    in the table.
@@ -198,3 +198,8 @@ int umount(const char *path)
 {
 	return syscall1(SYS_UMOUNT, path);
 }
+
+void *get_phys_addr(void *user_addr)
+{
+	return (void *)syscall1(SYS_GET_PHYS_ADDR, user_addr);
+}
@@ -0,0 +1,83 @@
+/* Puts 10,000 threads to sleep on deadlines spread over a few
+   seconds and measures how many CPU cycles the timer interrupt
+   handler takes per tick while they wake up.  Verifies that
+   every thread wakes up and that none of them wakes up early. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPER_CNT 10000       /* Number of sleeping threads. */
+#define SLEEP_SPREAD 500        /* Deadlines are spread over this many ticks. */
+
+/* Information about the test. */
+struct stress_test 
+  {
+    struct semaphore done;      /* Upped by the last thread to wake. */
+    int woken;                  /* Number of threads that woke up. */
+    int early;                  /* Number of threads that woke up early. */
+  };
+
+static struct stress_test test;
+static thread_func sleeper;
+
+void
+test_alarm_stress (void) 
+{
+  int64_t count;
+  uint64_t avg_cycles, max_cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating %d threads to sleep up to %d ticks each.",
+       SLEEPER_CNT, SLEEP_SPREAD);
+
+  sema_init (&test.done, 0);
+  test.woken = 0;
+  test.early = 0;
+  timer_intr_stats_reset ();
+
+  /* Sleepers have a higher priority than us, so each one runs
+     and goes to sleep as soon as it is created. */
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT + 1, sleeper,
+                         (void *) (intptr_t) i) == TID_ERROR)
+        fail ("thread_create() failed for sleeper %d", i);
+    }
+
+  sema_down (&test.done);
+  timer_intr_stats (&count, &avg_cycles, &max_cycles);
+
+  msg ("%d threads woke up, %d of them early.", test.woken, test.early);
+  msg ("Timer interrupt: %lld ticks, %llu cycles avg, %llu cycles max.",
+       count, avg_cycles, max_cycles);
+}
+
+/* Sleeper thread.  Sleeps for a duration derived from its index
+   and records whether it woke up too soon. */
+static void
+sleeper (void *idx_) 
+{
+  int idx = (intptr_t) idx_;
+  int64_t duration = 1 + (idx * 7919) % SLEEP_SPREAD;
+  int64_t start = timer_ticks ();
+  enum intr_level old_level;
+
+  timer_sleep (duration);
+
+  old_level = intr_disable ();
+  if (timer_elapsed (start) < duration)
+    test.early++;
+  if (++test.woken == SLEEPER_CNT)
+    sema_up (&test.done);
+  intr_set_level (old_level);
+}
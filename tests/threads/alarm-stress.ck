@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "missing begin message\n"
+  if !grep ($_ eq '(alarm-stress) begin', @output);
+fail "missing end message\n"
+  if !grep ($_ eq '(alarm-stress) end', @output);
+fail "not all sleepers woke up on time\n"
+  if !grep ($_ eq '(alarm-stress) 10000 threads woke up, 0 of them early.',
+	    @output);
+fail "timer interrupt statistics missing\n"
+  if !grep (/^\(alarm-stress\) Timer interrupt: \d+ ticks, \d+ cycles avg, \d+ cycles max\.$/,
+	    @output);
+pass;
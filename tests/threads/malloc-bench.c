@@ -0,0 +1,80 @@
+/* Measures malloc()/free() pairs with and without the per-CPU
+   magazine layer.  "single" allocates and frees one block at a
+   time, which used to get and free an arena page on every
+   iteration when no other block of that size was live.  "batch"
+   allocates BATCH blocks before freeing them all. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define PAIRS 100000
+#define BATCH 64
+
+static void *blocks[BATCH];
+
+static void measure (const char *name, bool magazines, size_t size,
+                     bool batch);
+
+void
+test_malloc_bench (void) 
+{
+  static const size_t sizes[] = {32, 128, 1000};
+  size_t i;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      measure ("locked", false, sizes[i], false);
+      measure ("magazine", true, sizes[i], false);
+      measure ("locked", false, sizes[i], true);
+      measure ("magazine", true, sizes[i], true);
+    }
+  malloc_magazines = true;
+}
+
+/* Runs PAIRS malloc()/free() pairs of SIZE bytes, one at a time
+   or BATCH at a time, with the magazines on or off. */
+static void
+measure (const char *name, bool magazines, size_t size, bool batch) 
+{
+  int64_t start_ticks, ticks;
+  uint64_t start, cycles;
+  int i, j;
+
+  malloc_magazines = magazines;
+  start_ticks = timer_ticks ();
+  start = rdtsc ();
+  if (!batch) 
+    {
+      for (i = 0; i < PAIRS; i++) 
+        {
+          void *p = malloc (size);
+          if (p == NULL)
+            fail ("malloc (%zu) failed", size);
+          free (p);
+        }
+    }
+  else
+    {
+      for (i = 0; i < PAIRS / BATCH; i++) 
+        {
+          for (j = 0; j < BATCH; j++)
+            if ((blocks[j] = malloc (size)) == NULL)
+              fail ("malloc (%zu) failed", size);
+          for (j = 0; j < BATCH; j++)
+            free (blocks[j]);
+        }
+    }
+  cycles = rdtsc () - start;
+  ticks = timer_elapsed (start_ticks);
+
+  if (ticks == 0)
+    ticks = 1;
+  msg ("%s %zu-byte %s: %llu cycles per malloc+free, "
+       "%lld pairs per second.",
+       name, size, batch ? "batch" : "single",
+       cycles / PAIRS, (int64_t) PAIRS * TIMER_FREQ / ticks);
+}
@@ -0,0 +1,89 @@
+/* Measures the cost of the timer interrupt, including the MLFQS
+   bookkeeping it performs, with 1, 100 and 1000 runnable threads.
+
+   The main thread raises its own priority with nice -20 and
+   starts spinner threads that lower theirs with nice 20, so the
+   spinners stay runnable without preempting the main thread.
+   The main thread then sleeps for a few seconds while the timer
+   interrupt runs as usual and reports the average and the
+   largest handler cost.  The largest one is a second-boundary
+   step: load_avg, recent_cpu decay and priority recomputation
+   of every runnable thread.  Only the kernel's interrupt
+   statistics are reset; the scheduler state is left alone. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Seconds to measure for at each thread count. */
+#define SECONDS 3
+
+static struct semaphore exit_sema;
+static volatile bool done;
+static volatile int started;
+
+static void spinner (void *aux);
+
+void
+test_mlfqs_bench (void) 
+{
+  static const int counts[] = {1, 100, 1000};
+  int created = 0;
+  size_t i;
+
+  ASSERT (thread_mlfqs);
+
+  sema_init (&exit_sema, 0);
+  done = false;
+  started = 0;
+  thread_set_nice (-20);
+
+  for (i = 0; i < sizeof counts / sizeof *counts; i++) 
+    {
+      int64_t intr_cnt;
+      uint64_t avg_cycles, max_cycles;
+
+      for (; created < counts[i]; created++) 
+        {
+          char name[20];
+          snprintf (name, sizeof name, "spinner %d", created);
+          thread_create (name, PRI_DEFAULT, spinner, NULL);
+        }
+
+      /* Let every spinner run once so that it lowers its priority. */
+      while (started < created)
+        timer_sleep (1);
+
+      timer_intr_stats_reset ();
+      timer_sleep (SECONDS * TIMER_FREQ);
+      timer_intr_stats (&intr_cnt, &avg_cycles, &max_cycles);
+
+      msg ("%d threads: %llu cycles per timer interrupt, %llu at most "
+           "(%lld interrupts).",
+           counts[i], avg_cycles, max_cycles, intr_cnt);
+    }
+
+  done = true;
+  for (; created > 0; created--)
+    sema_down (&exit_sema);
+}
+
+static void
+spinner (void *aux UNUSED) 
+{
+  enum intr_level old_level;
+
+  thread_set_nice (20);
+
+  old_level = intr_disable ();
+  started++;
+  intr_set_level (old_level);
+
+  while (!done)
+    continue;
+  sema_up (&exit_sema);
+}
@@ -0,0 +1,98 @@
+/* Exercises the page allocator on a fragmented user pool.
+
+   Fills up to MAX_PAGES single pages, then frees every other
+   page of the first half (leaving single-page holes) and all of
+   the second half.  It reports the cost of getting and freeing
+   runs of several sizes in that state, then frees everything and
+   checks that the pool coalesces back to the largest run it had
+   at the start.  The per-CPU page caches are drained before each
+   largest-run check so that cached single pages do not split
+   runs. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "intrinsic.h"
+
+#define MAX_PAGES 4096
+#define ROUNDS 10000
+
+static void *pages[MAX_PAGES];
+
+static size_t largest_run (void);
+static void measure (size_t page_cnt);
+
+void
+test_palloc_bench (void) 
+{
+  static const size_t page_cnts[] = {1, 3, 16, 64};
+  size_t before, after;
+  size_t n, i;
+
+  palloc_drain_caches ();
+  before = largest_run ();
+
+  for (n = 0; n < MAX_PAGES; n++)
+    if ((pages[n] = palloc_get_page (PAL_USER)) == NULL)
+      break;
+  for (i = 0; i < n / 2; i += 2)
+    palloc_free_page (pages[i]);
+  for (i = n / 2; i < n; i++)
+    palloc_free_page (pages[i]);
+  msg ("holes: %zu pages in use, largest run %zu pages.",
+       n / 4, largest_run ());
+
+  for (i = 0; i < sizeof page_cnts / sizeof *page_cnts; i++)
+    measure (page_cnts[i]);
+
+  for (i = 1; i < n / 2; i += 2)
+    palloc_free_page (pages[i]);
+  palloc_drain_caches ();
+  after = largest_run ();
+  msg ("coalesced: largest run %zu pages.", after);
+  if (after != before)
+    fail ("largest run was %zu pages before the test", before);
+}
+
+/* Returns the largest number of contiguous user pages that can
+   be allocated at once. */
+static size_t
+largest_run (void) 
+{
+  size_t lo = 0, hi = 1 << 16;
+
+  while (lo < hi) 
+    {
+      size_t mid = (lo + hi + 1) / 2;
+      void *p = palloc_get_multiple (PAL_USER, mid);
+      if (p != NULL) 
+        {
+          palloc_free_multiple (p, mid);
+          lo = mid;
+        }
+      else
+        hi = mid - 1;
+    }
+  return lo;
+}
+
+/* Reports the average cost of getting and freeing PAGE_CNT
+   contiguous user pages. */
+static void
+measure (size_t page_cnt) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < ROUNDS; i++) 
+    {
+      void *p = palloc_get_multiple (PAL_USER, page_cnt);
+      if (p == NULL)
+        fail ("palloc_get_multiple (%zu) failed", page_cnt);
+      palloc_free_multiple (p, page_cnt);
+    }
+  cycles = rdtsc () - start;
+  msg ("%zu-page: %llu cycles per get+free.", page_cnt, cycles / ROUNDS);
+}
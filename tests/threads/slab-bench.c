@@ -0,0 +1,128 @@
+/* Compares malloc() against a kmem_cache for a few object sizes
+   that match hot kernel structures.  For each size it reports
+   how many bytes of page memory one object really costs and how
+   many alloc/free pairs per second each allocator sustains. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define OBJ_CNT 1000
+#define ROUNDS 100
+
+static void *objs[OBJ_CNT];
+static void *pages[OBJ_CNT];
+
+static void measure (size_t size);
+static size_t bytes_per_object (void);
+static void report (const char *name, size_t size, size_t bytes,
+                    uint64_t cycles, int64_t ticks);
+
+void
+test_slab_bench (void) 
+{
+  /* Roughly struct lazy_load_arg, struct frame, struct page and
+     struct inode, plus one size in between. */
+  static const size_t sizes[] = {24, 32, 80, 136, 544};
+  size_t i;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    measure (sizes[i]);
+}
+
+/* Measures malloc() and a fresh kmem_cache for SIZE-byte
+   objects. */
+static void
+measure (size_t size) 
+{
+  struct kmem_cache *cache;
+  int64_t start_ticks, ticks;
+  uint64_t start, cycles;
+  size_t bytes;
+  int i, r;
+
+  /* malloc(). */
+  for (i = 0; i < OBJ_CNT; i++)
+    if ((objs[i] = malloc (size)) == NULL)
+      fail ("malloc (%zu) failed", size);
+  bytes = bytes_per_object ();
+  for (i = 0; i < OBJ_CNT; i++)
+    free (objs[i]);
+
+  start_ticks = timer_ticks ();
+  start = rdtsc ();
+  for (r = 0; r < ROUNDS; r++) 
+    {
+      for (i = 0; i < OBJ_CNT; i++)
+        objs[i] = malloc (size);
+      for (i = 0; i < OBJ_CNT; i++)
+        free (objs[i]);
+    }
+  cycles = rdtsc () - start;
+  ticks = timer_elapsed (start_ticks);
+  report ("malloc", size, bytes, cycles, ticks);
+
+  /* kmem_cache. */
+  cache = kmem_cache_create ("slab-bench", size, NULL);
+  if (cache == NULL)
+    fail ("kmem_cache_create (%zu) failed", size);
+  for (i = 0; i < OBJ_CNT; i++)
+    if ((objs[i] = kmem_cache_alloc (cache)) == NULL)
+      fail ("kmem_cache_alloc (%zu) failed", size);
+  bytes = bytes_per_object ();
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (cache, objs[i]);
+
+  start_ticks = timer_ticks ();
+  start = rdtsc ();
+  for (r = 0; r < ROUNDS; r++) 
+    {
+      for (i = 0; i < OBJ_CNT; i++)
+        objs[i] = kmem_cache_alloc (cache);
+      for (i = 0; i < OBJ_CNT; i++)
+        kmem_cache_free (cache, objs[i]);
+    }
+  cycles = rdtsc () - start;
+  ticks = timer_elapsed (start_ticks);
+  report ("kmem_cache", size, bytes, cycles, ticks);
+
+  kmem_cache_destroy (cache);
+}
+
+/* Returns the number of page bytes spent per object in OBJS,
+   counting every distinct page the objects live in. */
+static size_t
+bytes_per_object (void) 
+{
+  size_t page_cnt = 0;
+  size_t i, j;
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      void *page = pg_round_down (objs[i]);
+      for (j = 0; j < page_cnt; j++)
+        if (pages[j] == page)
+          break;
+      if (j == page_cnt)
+        pages[page_cnt++] = page;
+    }
+  return page_cnt * PGSIZE / OBJ_CNT;
+}
+
+static void
+report (const char *name, size_t size, size_t bytes,
+        uint64_t cycles, int64_t ticks) 
+{
+  int64_t allocs = (int64_t) ROUNDS * OBJ_CNT;
+
+  if (ticks == 0)
+    ticks = 1;
+  msg ("%s %zu: %zu bytes per object, %llu cycles per alloc+free, "
+       "%lld allocs per second.",
+       name, size, bytes, cycles / allocs, allocs * TIMER_FREQ / ticks);
+}
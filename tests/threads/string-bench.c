@@ -0,0 +1,145 @@
+/* Times memcpy(), memmove(), memset(), memcmp() and strlen()
+   from lib/string.c on blocks from 8 bytes to 4 kB, next to a
+   plain byte-at-a-time loop doing the same work.  Also checks
+   that each function's result matches the byte loop. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "intrinsic.h"
+
+#define ITERS 2000
+#define MAX_SIZE 4096
+
+static char src[MAX_SIZE + 8];
+static char dst[MAX_SIZE + 8];
+
+enum op 
+  {
+    OP_MEMCPY,
+    OP_MEMMOVE,
+    OP_MEMSET,
+    OP_MEMCMP,
+    OP_STRLEN,
+    OP_CNT
+  };
+
+static const char *op_names[OP_CNT] =
+  {"memcpy", "memmove", "memset", "memcmp", "strlen"};
+
+static size_t run (enum op, bool bytewise, size_t size);
+static void measure (enum op, size_t size);
+
+void
+test_string_bench (void) 
+{
+  static const size_t sizes[] = {8, 64, 512, 4096};
+  size_t i;
+  int op;
+
+  for (op = 0; op < OP_CNT; op++)
+    for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+      measure (op, sizes[i]);
+}
+
+/* Reports the cost of OP on SIZE bytes with lib/string.c and
+   with a byte loop, after checking that both agree. */
+static void
+measure (enum op op, size_t size) 
+{
+  uint64_t start, fast, slow;
+  size_t expected, actual;
+  int i;
+
+  expected = run (op, true, size);
+  actual = run (op, false, size);
+  if (actual != expected)
+    fail ("%s %zu: got %zu, expected %zu",
+          op_names[op], size, actual, expected);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    run (op, false, size);
+  fast = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    run (op, true, size);
+  slow = rdtsc () - start;
+
+  msg ("%s %zu: %llu cycles, byte loop %llu cycles.",
+       op_names[op], size, fast / ITERS, slow / ITERS);
+}
+
+/* Performs OP once on SIZE bytes, with lib/string.c or, if
+   BYTEWISE, with a byte loop.  Returns a value that depends on
+   the result, for checking. */
+static size_t
+run (enum op op, bool bytewise, size_t size) 
+{
+  size_t i, sum;
+
+  /* Fill SRC with a nonzero pattern and a null terminator. */
+  for (i = 0; i < size; i++)
+    src[i] = 'a' + i % 26;
+  src[size] = '\0';
+
+  switch (op) 
+    {
+    case OP_MEMCPY:
+      if (bytewise)
+        for (i = 0; i < size; i++)
+          dst[i] = src[i];
+      else
+        memcpy (dst, src, size);
+      break;
+
+    case OP_MEMMOVE:
+      /* Overlapping: shift SRC up by 8 bytes. */
+      if (bytewise)
+        for (i = size; i-- > 0; )
+          src[i + 8] = src[i];
+      else
+        memmove (src + 8, src, size);
+      memcpy (dst, src, size + 8);
+      size += 8;
+      break;
+
+    case OP_MEMSET:
+      if (bytewise)
+        for (i = 0; i < size; i++)
+          dst[i] = 0x5a;
+      else
+        memset (dst, 0x5a, size);
+      break;
+
+    case OP_MEMCMP:
+      memcpy (dst, src, size);
+      dst[size - 1]++;
+      if (bytewise) 
+        {
+          for (i = 0; i < size; i++)
+            if (src[i] != dst[i])
+              break;
+          return i < size ? (unsigned char) src[i] < (unsigned char) dst[i] : 2;
+        }
+      return memcmp (src, dst, size) < 0;
+
+    case OP_STRLEN:
+      if (bytewise) 
+        {
+          for (i = 0; src[i] != '\0'; i++)
+            continue;
+          return i;
+        }
+      return strlen (src);
+
+    default:
+      NOT_REACHED ();
+    }
+
+  for (sum = i = 0; i < size; i++)
+    sum = sum * 31 + (unsigned char) dst[i];
+  return sum;
+}
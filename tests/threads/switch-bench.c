@@ -0,0 +1,80 @@
+/* Measures how fast two threads can hand control back and forth
+   through a pair of semaphores.  Each round is two context
+   switches.  The benchmark runs once with the full intr_frame
+   switch (thread_iret_switch) and once with switch_threads(),
+   which only saves the callee-saved registers. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define ROUNDS 100000
+
+struct ping_pong
+  {
+    struct semaphore ping;
+    struct semaphore pong;
+  };
+
+static thread_func pong_thread;
+static void measure (const char *name, bool iret);
+
+void
+test_switch_bench (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  measure ("intr_frame", true);
+  measure ("switch_threads", false);
+}
+
+/* Runs ROUNDS ping-pong rounds with the switch path selected by
+   IRET and reports the cost and rate of context switches. */
+static void
+measure (const char *name, bool iret) 
+{
+  struct ping_pong pp;
+  int64_t start_ticks, ticks;
+  uint64_t start, cycles;
+  int64_t switches = 2 * ROUNDS;
+  int i;
+
+  sema_init (&pp.ping, 0);
+  sema_init (&pp.pong, 0);
+  thread_iret_switch = iret;
+  thread_create ("pong", PRI_DEFAULT, pong_thread, &pp);
+
+  start_ticks = timer_ticks ();
+  start = rdtsc ();
+  for (i = 0; i < ROUNDS; i++) 
+    {
+      sema_up (&pp.ping);
+      sema_down (&pp.pong);
+    }
+  cycles = rdtsc () - start;
+  ticks = timer_elapsed (start_ticks);
+  thread_iret_switch = false;
+
+  if (ticks == 0)
+    ticks = 1;
+  msg ("%s: %llu cycles per switch, %lld switches per second.",
+       name, cycles / switches, switches * TIMER_FREQ / ticks);
+}
+
+static void
+pong_thread (void *pp_) 
+{
+  struct ping_pong *pp = pp_;
+  int i;
+
+  for (i = 0; i < ROUNDS; i++) 
+    {
+      sema_down (&pp->ping);
+      sema_up (&pp->pong);
+    }
+}
@@ -0,0 +1,75 @@
+/* Forks N CPU-bound children at once for N = 1, 2, 4, 8 and
+   reports the wall-clock speedup over running them one at a
+   time.  The first command-line argument is the number of CPUs
+   the kernel was booted with, which bounds the ideal speedup. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "fork-speedup";
+
+/* Iterations of busy work done by each child. */
+#define WORK 20000000
+
+/* Largest number of children forked at once. */
+#define MAX_CHILDREN 8
+
+/* Spins for WORK iterations without touching memory. */
+static void
+spin (void)
+{
+  volatile int i;
+  for (i = 0; i < WORK; i++)
+    continue;
+}
+
+/* Forks CNT children that each spin once, waits for all of them,
+   and returns the elapsed cycles. */
+static uint64_t
+run_children (int cnt)
+{
+  pid_t pids[MAX_CHILDREN];
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        {
+          spin ();
+          exit (0);
+        }
+      if (pids[i] < 0)
+        fail ("fork() returned %d", pids[i]);
+    }
+  for (i = 0; i < cnt; i++)
+    if (wait (pids[i]) != 0)
+      fail ("child %d did not exit cleanly", i);
+  return rdtsc () - start;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cpu_cnt = argc > 1 ? atoi (argv[1]) : 1;
+  uint64_t one;
+  int n;
+
+  msg ("begin");
+  one = run_children (1);
+  msg ("1 child: %llu cycles", one);
+  for (n = 2; n <= MAX_CHILDREN; n *= 2)
+    {
+      uint64_t cycles = run_children (n);
+      uint64_t speedup = n * one * 100 / cycles;
+      int ideal = n < cpu_cnt ? n : cpu_cnt;
+
+      msg ("%d children: %llu cycles, speedup %llu.%02llu (ideal %d on %d CPUs)",
+           n, cycles, speedup / 100, speedup % 100, ideal, cpu_cnt);
+    }
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,43 @@
+/* Measures page-fault throughput.  Touches every page of a large
+   zero-filled buffer once, so that each access takes a fault that
+   looks the page up in the supplemental page table and claims a
+   frame, then touches the pages again, which takes no faults, and
+   reports the difference as the cost of one fault. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 512
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Writes one byte to every page of BUF and returns the elapsed
+   cycles. */
+static uint64_t
+touch_pages (char value)
+{
+  uint64_t start = rdtsc ();
+  volatile char *p = buf;
+  size_t i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    p[i * PAGE_SIZE] = value;
+  return rdtsc () - start;
+}
+
+void
+test_main (void)
+{
+  uint64_t faulting = touch_pages (1);
+  uint64_t resident = touch_pages (2);
+  size_t i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != 2)
+      fail ("page %zu lost its contents", i);
+
+  msg ("%d faults: %llu cycles per fault", PAGE_CNT,
+       (faulting - (faulting > resident ? resident : faulting)) / PAGE_CNT);
+}
@@ -0,0 +1,67 @@
+/* Measures the cost of reading a mapped file sequentially and in
+   random page order.  Maps "large.txt" read-only, reads one byte
+   from every page in order and reports the cycles per page, then
+   unmaps it, maps it again so that nothing is resident, and reads
+   the pages in a shuffled order.  Readahead should make the
+   sequential pass much cheaper per page than the random one, and
+   both passes must see the same bytes. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+#define PAGE_SIZE 4096
+#define MAX_PAGES 1024
+
+static size_t order[MAX_PAGES];
+
+/* Maps "large.txt", reads the first byte of each of its PAGE_CNT
+   pages in ORDER, unmaps it, and returns the elapsed cycles.  The
+   sum of the bytes read is stored in *SUM. */
+static uint64_t
+read_pages (int handle, size_t page_cnt, unsigned long *sum)
+{
+  volatile char *map;
+  uint64_t start;
+  size_t i;
+
+  CHECK ((map = mmap (ACTUAL, page_cnt * PAGE_SIZE, 0, handle, 0))
+         != MAP_FAILED, "mmap \"large.txt\"");
+  *sum = 0;
+  start = rdtsc ();
+  for (i = 0; i < page_cnt; i++)
+    *sum += map[order[i] * PAGE_SIZE];
+  start = rdtsc () - start;
+  munmap ((void *) map);
+  return start;
+}
+
+void
+test_main (void)
+{
+  unsigned long seq_sum, rnd_sum;
+  uint64_t seq, rnd;
+  size_t page_cnt, i;
+  int handle;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  page_cnt = filesize (handle) / PAGE_SIZE;
+  if (page_cnt > MAX_PAGES)
+    page_cnt = MAX_PAGES;
+
+  for (i = 0; i < page_cnt; i++)
+    order[i] = i;
+  seq = read_pages (handle, page_cnt, &seq_sum);
+
+  shuffle (order, page_cnt, sizeof *order);
+  rnd = read_pages (handle, page_cnt, &rnd_sum);
+
+  if (seq_sum != rnd_sum)
+    fail ("sequential and random passes read different data");
+  close (handle);
+
+  msg ("sequential: %llu cycles per page", seq / page_cnt);
+  msg ("random: %llu cycles per page", rnd / page_cnt);
+}
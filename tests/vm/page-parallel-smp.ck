@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-parallel-smp) begin
+(page-parallel-smp) wait for child 0
+(page-parallel-smp) wait for child 1
+(page-parallel-smp) wait for child 2
+(page-parallel-smp) wait for child 3
+(page-parallel-smp) end
+EOF
+pass;
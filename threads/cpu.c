@@ -0,0 +1,264 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/lapic.h"
+#include "devices/timer.h"
+#include "threads/fpu.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/syscall.h"
+#include "userprog/tss.h"
+#endif
+
+/* NOTE: [Improve] SMP 부팅과 CPU 간 통신.
+
+   BSP(부트 CPU)는 cpu_init_bsp()로 자신의 struct cpu를 준비한 뒤 평소처럼
+   커널을 초기화하고, cpu_start_aps()에서 나머지 CPU(AP)를 깨운다.
+   AP는 start.S의 ap_trampoline에서 시작해 long mode로 전환한 뒤
+   ap_main()으로 들어와 자기 idle 쓰레드가 된다. */
+
+/* 어셈블리가 쓰는 오프셋이 struct cpu와 맞는지 확인. */
+_Static_assert(offsetof(struct cpu, self) == CPU_SELF, "CPU_SELF");
+_Static_assert(offsetof(struct cpu, tss) == CPU_TSS, "CPU_TSS");
+_Static_assert(offsetof(struct cpu, scratch) == CPU_SCRATCH, "CPU_SCRATCH");
+
+/* CPU별 데이터. cpus[0]은 BSP. */
+struct cpu cpus[CPU_MAX];
+
+/* 부팅을 마친 CPU 수. */
+int cpu_cnt;
+
+/* Big kernel lock. 1이면 어떤 CPU가 커널 안에서 실행 중. */
+static volatile int kernel_lock;
+
+/* start.S의 AP 부팅 코드와 공유하는 값.
+   ap_boot_cnt는 AP가 lock xadd로 자기 번호를 정할 때 쓰고,
+   ap_stacks[i]는 i번째로 깨어난 AP가 쓸 스택(페이지 끝) 주소다. */
+volatile uint32_t ap_boot_cnt;
+uint64_t ap_stacks[CPU_MAX - 1];
+
+static void cpu_setup(struct cpu *c, int id);
+static void cpu_tlb_flush_local(void);
+static intr_handler_func reschedule_interrupt;
+static intr_handler_func tlb_shootdown_interrupt;
+
+/* NOTE: [Improve] BSP의 struct cpu를 준비하고 GS base에 연결한다.
+   thread_init()보다 먼저, 인터럽트가 꺼진 상태에서 호출해야 한다. */
+void cpu_init_bsp(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	cpu_setup(&cpus[0], 0);
+	cpus[0].online = true;
+	cpu_cnt = 1;
+
+	/* BSP는 부팅 중 커널 코드를 실행하므로 처음부터 kernel_lock을 잡는다. */
+	kernel_lock_acquire();
+}
+
+/* C를 ID번 CPU로 초기화하고 현재 CPU의 GS base로 설정한다. */
+static void
+cpu_setup(struct cpu *c, int id)
+{
+	memset(c, 0, sizeof *c);
+	c->self = c;
+	c->id = id;
+	write_msr(MSR_GS_BASE, (uint64_t)c);
+	write_msr(MSR_KERNEL_GS_BASE, 0);
+}
+
+/** NOTE: [Improve]
+ * @brief Local APIC를 켜고 AP들을 깨우는 함수
+ *
+ * AP가 쓸 스택을 미리 나눠주고 부팅 코드를 1MB 아래로 복사한 뒤
+ * INIT-SIPI-SIPI를 모든 AP에게 보낸다. 깨어난 AP는 kernel_lock을 잡고
+ * 초기화하므로, BSP는 잠들어서 kernel_lock을 넘겨주며 기다린다.
+ * 기다린 뒤에는 ap_boot_cnt를 닫아 더 늦게 깨어나는 AP가 스택을 가져가지 못하게
+ * 하고, 이미 번호를 받은 AP(스택으로 전환 중일 수 있음)는 online이 될 때까지
+ * 기다린다. 아무도 가져가지 않은 스택만 돌려받는다.
+ */
+void cpu_start_aps(void)
+{
+	extern char ap_trampoline[], ap_trampoline_end[];
+	uint32_t claimed;
+	int i;
+
+	lapic_init();
+	cpus[0].lapic_id = lapic_id();
+
+	intr_register_ipi(IPI_RESCHEDULE, reschedule_interrupt, "IPI Reschedule");
+	intr_register_ipi(IPI_TLB_SHOOTDOWN, tlb_shootdown_interrupt, "IPI TLB Shootdown");
+
+	for (i = 0; i < CPU_MAX - 1; i++)
+		ap_stacks[i] = (uint64_t)palloc_get_page(PAL_ASSERT | PAL_ZERO) + PGSIZE;
+	memcpy(ptov(AP_TRAMPOLINE), ap_trampoline, ap_trampoline_end - ap_trampoline);
+
+	lapic_start_aps(AP_TRAMPOLINE);
+	timer_msleep(100);
+
+	/* 이후에 lock xadd하는 AP는 CPU_MAX - 1 이상을 받아 멈춘다.
+	   그 전에 받은 번호 0..claimed-1의 AP는 이미 ap_stacks[i]를 쓰고 있다. */
+	claimed = __atomic_exchange_n(&ap_boot_cnt, CPU_MAX - 1, __ATOMIC_SEQ_CST);
+	if (claimed > CPU_MAX - 1)
+		claimed = CPU_MAX - 1;
+	while (cpu_cnt < 1 + (int)claimed)
+		timer_msleep(1);
+
+	for (i = claimed; i < CPU_MAX - 1; i++)
+	{
+		void *stack = (void *)(ap_stacks[i] - PGSIZE);
+		ap_stacks[i] = 0;
+		palloc_free_page(stack);
+	}
+
+	if (cpu_cnt > 1)
+		printf("%d CPUs online.\n", cpu_cnt);
+}
+
+/** NOTE: [Improve]
+ * @brief AP가 start.S의 ap_entry_64에서 넘어와 실행하는 함수
+ *
+ * ID는 AP가 깨어난 순서(1부터)이며, 현재 스택은 ap_stacks에서 받은 페이지다.
+ * 이 페이지가 그대로 이 CPU의 idle 쓰레드가 된다. 돌아오지 않는다.
+ */
+void ap_main(int id)
+{
+	struct cpu *c = &cpus[id];
+
+	cpu_setup(c, id);
+	intr_init_ap();
+	fpu_init_cpu();
+	kernel_lock_acquire();
+
+	thread_init_ap();
+	lapic_init();
+	c->lapic_id = lapic_id();
+#ifdef USERPROG
+	tss_init();
+	gdt_init();
+	ltr(SEL_TSS);
+	syscall_init_cpu();
+#endif
+	pml4_activate(NULL);
+
+	c->online = true;
+	cpu_cnt++;
+
+	thread_run_idle();
+}
+
+/* NOTE: [Improve] C에 VEC 인터럽트를 보낸다. 자기 자신에게는 보내지 않는다. */
+void cpu_send_ipi(struct cpu *c, uint8_t vec)
+{
+	if (c != this_cpu() && c->online)
+		lapic_send_ipi(c->lapic_id, vec);
+}
+
+/* NOTE: [Improve] 자신을 뺀 모든 CPU에 VEC 인터럽트를 보낸다. */
+void cpu_broadcast_ipi(uint8_t vec)
+{
+	if (cpu_cnt > 1)
+		lapic_broadcast_ipi(vec);
+}
+
+/* IPI_RESCHEDULE: 더 높은 우선순위 쓰레드가 이 CPU의 run queue에 들어왔다.
+   idle 상태였다면 hlt에서 깨어나는 것만으로 다시 스케줄링된다. */
+static void
+reschedule_interrupt(struct intr_frame *f UNUSED)
+{
+	thread_compare_yield();
+}
+
+/* IPI_TLB_SHOOTDOWN: intr_handler()가 kernel_lock 없이 바로 부른다. */
+static void
+tlb_shootdown_interrupt(struct intr_frame *f UNUSED)
+{
+	cpu_tlb_flush_local();
+}
+
+/* 다른 CPU의 요청에 따라 이 CPU의 TLB를 비우고 요청을 완료로 표시한다. */
+static void
+cpu_tlb_flush_local(void)
+{
+	struct cpu *c = this_cpu();
+
+	if (c->tlb_flush_pending)
+	{
+		lcr3(rcr3());
+		c->tlb_flush_pending = false;
+	}
+}
+
+/** NOTE: [Improve]
+ * @brief PML4의 VA 매핑을 바꾼 뒤 모든 CPU에서 해당 TLB 항목을 무효화하는 함수
+ *
+ * 현재 CPU는 invlpg만 하면 되지만, 같은 PML4를 CR3에 올려둔 다른 CPU는
+ * IPI로 TLB를 비우게 하고 끝날 때까지 기다린다. 기다리는 동안 상대 CPU가
+ * kernel_lock을 기다리며 인터럽트를 끈 채 돌고 있을 수도 있으므로,
+ * kernel_lock_acquire()의 대기 루프도 이 요청을 처리한다.
+ */
+void cpu_tlb_invalidate(uint64_t *pml4, const void *va)
+{
+	int i;
+
+	if (rcr3() == vtop(pml4))
+		invlpg((uint64_t)va);
+	if (cpu_cnt == 1)
+		return;
+
+	ASSERT(kernel_lock_held());
+	for (i = 0; i < CPU_MAX; i++)
+		if (&cpus[i] != this_cpu() && cpus[i].online && cpus[i].pml4 == pml4)
+		{
+			cpus[i].tlb_flush_pending = true;
+			lapic_send_ipi(cpus[i].lapic_id, IPI_TLB_SHOOTDOWN);
+		}
+	for (i = 0; i < CPU_MAX; i++)
+		while (cpus[i].tlb_flush_pending)
+			cpu_relax();
+}
+
+/* NOTE: [Improve] kernel_lock을 잡는다. 이미 이 CPU가 잡고 있다면 아무것도 하지 않는다. */
+void kernel_lock_acquire(void)
+{
+	enum intr_level old_level = intr_disable();
+	struct cpu *c = this_cpu();
+
+	if (!c->kernel_locked)
+	{
+		while (__atomic_exchange_n(&kernel_lock, 1, __ATOMIC_ACQUIRE) != 0)
+			while (kernel_lock)
+			{
+				cpu_tlb_flush_local();
+				cpu_relax();
+			}
+		c->kernel_locked = true;
+	}
+	intr_set_level(old_level);
+}
+
+/* NOTE: [Improve] kernel_lock을 놓는다. 인터럽트가 꺼진 상태에서 불러야 한다. */
+void kernel_lock_release(void)
+{
+	struct cpu *c = this_cpu();
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(c->kernel_locked);
+
+	c->kernel_locked = false;
+	__atomic_store_n(&kernel_lock, 0, __ATOMIC_RELEASE);
+}
+
+/* NOTE: [Improve] 현재 CPU가 kernel_lock을 잡고 있으면 true */
+bool kernel_lock_held(void)
+{
+	return this_cpu()->kernel_locked;
+}
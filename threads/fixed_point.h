@@ -2,16 +2,88 @@
  * NOTE: [Part3] 고정소수점 연산에 필요한 로직
  *
  * 17.14 고정 소수점 숫자 표현을 사용합니다.
+ *
+ * NOTE: [Improve] 모든 연산을 헤더의 inline 함수로 제공하고, 상수는 매크로로
+ * 컴파일 시간에 계산합니다. 곱셈과 나눗셈은 64비트 중간값을 사용하므로
+ * 17.14 범위 안의 두 값을 곱하거나 나눠도 중간 결과가 넘치지 않습니다.
  */
 
-#define F (1 << 14) /* 1 in 17.14 format */
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+#define FP_SHIFT 14			/* 소수부 비트 수 */
+#define F (1 << FP_SHIFT) /* 1 in 17.14 format */
 
 typedef int32_t fixed_point; /* 고정 소수점을 나타내는 타입 */
 
-fixed_point int_to_fp(int n);
-int fp_to_int_round_zero(fixed_point x);
-int fp_to_int_round_near(fixed_point x);
-fixed_point add_fp(fixed_point x, fixed_point y);
-fixed_point sub_fp(fixed_point x, fixed_point y);
-fixed_point mul_fp(fixed_point x, fixed_point y);
-fixed_point div_fp(fixed_point x, fixed_point y);
+/* 컴파일 시간 상수: 정수 N, 분수 N / D를 고정 소수점으로 표현 */
+#define FP_CONST(N) ((fixed_point)((N) * F))
+#define FP_FRAC(N, D) ((fixed_point)(((int64_t)(N) * F) / (D)))
+
+/* 정수 N을 고정 소수점으로 변환 */
+static inline fixed_point int_to_fp(int n)
+{
+	return n * F;
+}
+
+/* 고정 소수점 X를 정수로 변환 (0 방향으로 버림) */
+static inline int fp_to_int_round_zero(fixed_point x)
+{
+	return x / F;
+}
+
+/* 고정 소수점 X를 정수로 변환 (가장 가까운 정수로 반올림) */
+static inline int fp_to_int_round_near(fixed_point x)
+{
+	return x >= 0 ? (x + F / 2) / F : (x - F / 2) / F;
+}
+
+static inline fixed_point add_fp(fixed_point x, fixed_point y)
+{
+	return x + y;
+}
+
+static inline fixed_point sub_fp(fixed_point x, fixed_point y)
+{
+	return x - y;
+}
+
+/* 고정 소수점 X에 정수 N을 더함 */
+static inline fixed_point add_fp_int(fixed_point x, int n)
+{
+	return x + n * F;
+}
+
+/* 고정 소수점 X에서 정수 N을 뺌 */
+static inline fixed_point sub_fp_int(fixed_point x, int n)
+{
+	return x - n * F;
+}
+
+/* 두 고정 소수점의 곱 (64비트 중간값 사용) */
+static inline fixed_point mul_fp(fixed_point x, fixed_point y)
+{
+	return (fixed_point)((int64_t)x * y / F);
+}
+
+/* 고정 소수점 X와 정수 N의 곱 */
+static inline fixed_point mul_fp_int(fixed_point x, int n)
+{
+	return x * n;
+}
+
+/* 두 고정 소수점의 나눗셈 (64비트 중간값 사용) */
+static inline fixed_point div_fp(fixed_point x, fixed_point y)
+{
+	return (fixed_point)((int64_t)x * F / y);
+}
+
+/* 고정 소수점 X를 정수 N으로 나눔 */
+static inline fixed_point div_fp_int(fixed_point x, int n)
+{
+	return x / n;
+}
+
+#endif /* threads/fixed_point.h */
@@ -0,0 +1,173 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* NOTE: [Improve] x87/SSE 상태의 지연(lazy) 저장과 복원.
+
+   커널은 -mno-sse -msoft-float로 빌드되어 FPU를 쓰지 않으므로 FPU 레지스터는
+   유저 프로그램만 사용한다. 문맥 교환 때마다 512바이트를 저장/복원하는 대신
+   CR0.TS를 켜두고, 쓰레드가 time slice 안에서 처음 FPU 명령을 실행할 때
+   발생하는 #NM에서 그 쓰레드의 상태를 복원한다.
+
+   - FPU를 한 번도 쓰지 않은 쓰레드는 저장 영역도 없고 비용도 없다.
+   - 이번 time slice에 FPU를 쓴 쓰레드(fpu_used)만 CPU를 내놓을 때 FXSAVE한다.
+     쓰레드가 다른 CPU로 옮겨갈 수 있으므로 저장은 내놓을 때 바로 한다.
+   - 같은 CPU로 돌아왔고 그 사이 아무도 FPU를 쓰지 않았다면(fpu_owner) 레지스터에
+     아직 자기 상태가 남아 있으므로 #NM에서 FXRSTOR도 건너뛴다. */
+
+#define CR0_MP 0x00000002 /* Monitor coprocessor: TS일 때 WAIT도 #NM. */
+#define CR0_EM 0x00000004 /* x87 에뮬레이션 (꺼야 함). */
+#define CR0_TS 0x00000008 /* Task switched: FPU 명령이 #NM을 일으킴. */
+#define CR0_NE 0x00000020 /* x87 오류를 #MF로 보고. */
+
+#define CR4_OSFXSR 0x00000200	  /* FXSAVE/FXRSTOR와 SSE 명령 허용. */
+#define CR4_OSXMMEXCPT 0x00000400 /* SSE 예외를 #XF로 보고. */
+
+/* FNINIT 직후와 같은 초기 상태의 제어 워드 */
+#define FPU_DEFAULT_FCW 0x037f
+#define FPU_DEFAULT_MXCSR 0x1f80
+
+static bool fpu_alloc(struct thread *t);
+static void fpu_nm_handler(struct intr_frame *f);
+
+/* 현재 CPU에서 CR0.TS가 켜져 있게 한다. */
+static inline void
+stts(void)
+{
+	lcr0(rcr0() | CR0_TS);
+}
+
+/* NOTE: [Improve] BSP의 FPU를 설정하고 #NM 핸들러를 등록한다. */
+void fpu_init(void)
+{
+	fpu_init_cpu();
+	intr_register_int(7, 0, INTR_OFF, fpu_nm_handler,
+					  "#NM Device Not Available Exception");
+}
+
+/* NOTE: [Improve] 현재 CPU에서 SSE를 켜고, 첫 FPU 명령이 #NM을 일으키도록 TS를 켠다.
+   AP는 ap_main()에서 각자 호출한다. */
+void fpu_init_cpu(void)
+{
+	lcr4(rcr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+	lcr0((rcr0() | CR0_MP | CR0_NE | CR0_TS) & ~(uint64_t)CR0_EM);
+	this_cpu()->fpu_owner = NULL;
+}
+
+/** NOTE: [Improve]
+ * @brief CPU를 내놓는 CURR의 FPU 상태를 필요할 때만 저장하는 함수
+ *
+ * schedule()에서 인터럽트가 꺼진 상태로 호출된다. CURR가 이번 time slice에
+ * FPU를 쓰지 않았다면 TS가 이미 켜져 있으므로 할 일이 없다.
+ */
+void fpu_switch(struct thread *curr)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!curr->fpu_used)
+		return;
+
+	fxsave(curr->fpu);
+	curr->fpu_used = false;
+	stts();
+}
+
+/** NOTE: [Improve]
+ * @brief SRC의 저장된 FPU 상태를 DST에 복사하는 함수 (fork용)
+ *
+ * SRC는 CPU를 내놓은 상태여야 한다. SRC가 FPU를 쓴 적이 없으면 DST도 없이 시작한다.
+ */
+bool fpu_copy(struct thread *dst, const struct thread *src)
+{
+	ASSERT(!src->fpu_used);
+
+	if (src->fpu == NULL)
+		return true;
+	if (dst->fpu == NULL && !fpu_alloc(dst))
+		return false;
+	memcpy(dst->fpu, src->fpu, FPU_AREA_SIZE);
+	return true;
+}
+
+/** NOTE: [Improve]
+ * @brief 현재 쓰레드의 FPU 상태를 버리는 함수 (exec, exit)
+ *
+ * 다음에 FPU를 쓰면 #NM에서 초기 상태로 새로 시작한다.
+ */
+void fpu_release(void)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	void *area;
+
+	old_level = intr_disable();
+	if (curr->fpu_used)
+	{
+		curr->fpu_used = false;
+		stts();
+	}
+	if (this_cpu()->fpu_owner == curr)
+		this_cpu()->fpu_owner = NULL;
+	curr->fpu_cpu = -1;
+	area = curr->fpu_area;
+	curr->fpu_area = NULL;
+	curr->fpu = NULL;
+	intr_set_level(old_level);
+
+	free(area);
+}
+
+/* T의 FXSAVE 영역을 할당하고 초기 상태로 채운다. malloc()은 16바이트 정렬을
+   보장하지 않으므로 여유를 두고 할당해서 맞춘다. */
+static bool
+fpu_alloc(struct thread *t)
+{
+	void *area = malloc(FPU_AREA_SIZE + FPU_AREA_ALIGN - 1);
+	uint8_t *fpu;
+
+	if (area == NULL)
+		return false;
+	fpu = (uint8_t *)(((uintptr_t)area + FPU_AREA_ALIGN - 1) & ~(uintptr_t)(FPU_AREA_ALIGN - 1));
+	memset(fpu, 0, FPU_AREA_SIZE);
+	*(uint16_t *)(fpu + 0) = FPU_DEFAULT_FCW;
+	*(uint32_t *)(fpu + 24) = FPU_DEFAULT_MXCSR;
+
+	t->fpu_area = area;
+	t->fpu = fpu;
+	return true;
+}
+
+/** NOTE: [Improve]
+ * @brief #NM: 현재 쓰레드가 이번 time slice에서 처음으로 FPU 명령을 실행했다.
+ *
+ * 레지스터에 아직 자기 상태가 남아 있지 않다면 저장 영역에서 복원한 뒤
+ * TS를 끄고 명령을 다시 실행하게 한다.
+ */
+static void
+fpu_nm_handler(struct intr_frame *f UNUSED)
+{
+	struct thread *curr = thread_current();
+	struct cpu *c;
+
+	/* 할당이 잠들 수도 있으므로 TS를 끄기 전에 한다. 잠든 사이에
+	   다른 CPU로 옮겨졌을 수 있으니 CPU는 그 다음에 확인한다. */
+	if (curr->fpu == NULL && !fpu_alloc(curr))
+	{
+		curr->exit_status = -1;
+		thread_exit();
+	}
+
+	c = this_cpu();
+	clts();
+	if (c->fpu_owner != curr || curr->fpu_cpu != c->id)
+		fxrstor(curr->fpu);
+	c->fpu_owner = curr;
+	curr->fpu_cpu = c->id;
+	curr->fpu_used = true;
+}
@@ -21,6 +21,8 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/cpu.h"
+#include "threads/fpu.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -77,6 +79,10 @@ main (void) {
 	argv = read_command_line ();
 	argv = parse_options (argv);
 
+	/* NOTE: [Improve] Set up the BSP's per-CPU data before anything
+	   calls this_cpu (). */
+	cpu_init_bsp ();
+
 	/* Initialize ourselves as a thread so we can use locks,
 	   then enable console locking. */
 	thread_init ();
@@ -94,6 +100,7 @@ main (void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	fpu_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
@@ -106,6 +113,12 @@ main (void) {
 	serial_init_queue ();
 	timer_calibrate ();
 
+	/* NOTE: [Improve] Start clearing free pages in the background. */
+	palloc_start_zeroer ();
+
+	/* NOTE: [Improve] Bring up the application processors. */
+	cpu_start_aps ();
+
 #ifdef FILESYS
 	/* Initialize file system. */
 	disk_init ();
@@ -221,11 +234,17 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-idle-oneshot"))
+			timer_idle_oneshot = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-fa"))
+			fault_around_pages = atoi (value) > 0 ? atoi (value) : 1;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,8 +345,12 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -idle-oneshot      Batch up to 5 idle timer ticks (uniprocessor only).\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -fa=PAGES          Map up to PAGES pages around a file page fault.\n"
 #endif
 			);
 	power_off ();
@@ -354,6 +377,10 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	palloc_print_stats ();
+#ifdef VM
+	vm_print_stats ();
+#endif
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
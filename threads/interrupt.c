@@ -3,12 +3,14 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "devices/lapic.h"
 #include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
@@ -99,9 +101,12 @@ static const char *intr_names[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+   interrupt returns.
+
+   NOTE: [Improve] Inter-processor interrupts (IPIs, vectors
+   INTR_IPI_BASE and up) are handled as external interrupts too.
+   Whether we are processing an external interrupt, and whether we
+   should yield on return, are tracked per CPU in struct cpu. */
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
@@ -181,6 +186,9 @@ intr_init (void) {
 	/* Load IDT register. */
 	lidt(&idt_desc);
 
+	/* NOTE: [Improve] Local APIC spurious interrupts need no EOI. */
+	intr_names[IPI_SPURIOUS] = "Local APIC Spurious";
+
 	/* Initialize intr_names. */
 	intr_names[0] = "#DE Divide Error";
 	intr_names[1] = "#DB Debug Exception";
@@ -231,6 +239,24 @@ intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
+/* NOTE: [Improve] Loads the shared IDT on an application processor.
+   The PICs and the IDT itself were set up once by intr_init (). */
+void
+intr_init_ap (void) {
+	lidt(&idt_desc);
+}
+
+/* NOTE: [Improve] Registers HANDLER to be called when inter-processor
+   interrupt VEC_NO is received, named NAME for debugging purposes.
+   Like external interrupts, the handler runs with interrupts
+   disabled and may call intr_yield_on_return (). */
+void
+intr_register_ipi (uint8_t vec_no, intr_handler_func *handler,
+		const char *name) {
+	ASSERT (vec_no >= INTR_IPI_BASE && vec_no != IPI_SPURIOUS);
+	register_handler (vec_no, 0, INTR_OFF, handler, name);
+}
+
 /* Registers internal interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The interrupt handler
    will be invoked with interrupt status LEVEL.
@@ -256,7 +282,7 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
    and false at all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	return this_cpu ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -266,7 +292,7 @@ intr_context (void) {
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
-	yield_on_return = true;
+	this_cpu ()->yield_on_return = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -330,27 +356,44 @@ pic_end_of_interrupt (int irq) {
    interrupted thread's registers. */
 void
 intr_handler (struct intr_frame *frame) {
-	bool external;
+	bool external, ipi;
 	intr_handler_func *handler;
+	struct cpu *cpu;
+
+	/* NOTE: [Improve] A TLB shootdown is requested by a CPU that holds
+	   the kernel lock and spins until we acknowledge it, so handle it
+	   without taking the kernel lock. */
+	if (frame->vec_no == IPI_TLB_SHOOTDOWN) {
+		intr_handlers[IPI_TLB_SHOOTDOWN] (frame);
+		lapic_eoi ();
+		return;
+	}
+
+	/* NOTE: [Improve] Entering the kernel from user mode, or waking up
+	   an idle CPU: take the big kernel lock. */
+	kernel_lock_acquire ();
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	ipi = frame->vec_no >= INTR_IPI_BASE && frame->vec_no != IPI_SPURIOUS;
+	external = (frame->vec_no >= 0x20 && frame->vec_no < 0x30) || ipi;
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
-		in_external_intr = true;
-		yield_on_return = false;
+		cpu = this_cpu ();
+		cpu->in_external_intr = true;
+		cpu->yield_on_return = false;
 	}
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
 	if (handler != NULL)
 		handler (frame);
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f
+			|| frame->vec_no == IPI_SPURIOUS) {
 		/* There is no handler, but this interrupt can trigger
 		   spuriously due to a hardware fault or hardware race
 		   condition.  Ignore it. */
@@ -366,12 +409,23 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		cpu = this_cpu ();
+		cpu->in_external_intr = false;
+		if (ipi)
+			lapic_eoi ();
+		else
+			pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return)
+		if (cpu->yield_on_return)
 			thread_yield ();
 	}
+
+	/* NOTE: [Improve] Returning to user mode: let other CPUs into the
+	   kernel.  Interrupts stay off until iretq restores RFLAGS. */
+	if ((frame->cs & 3) == 3) {
+		intr_disable ();
+		kernel_lock_release ();
+	}
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
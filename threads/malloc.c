@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -32,16 +34,45 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   NOTE: [Improve] In front of the descriptors sits a per-CPU
+   "magazine" layer.  Each CPU keeps, for every descriptor, a
+   small stack of free blocks that only that CPU touches, with
+   interrupts off instead of a lock.  malloc() pops from it and
+   free() pushes onto it.  An empty magazine is refilled with a
+   batch of blocks taken from the descriptor under its lock; a
+   full one drains its oldest batch back.  Blocks sitting in a
+   magazine still count as in use by their arena.
+
+   Arenas are also released lazily: each descriptor keeps up to
+   ARENA_KEEP entirely free arenas around before handing pages
+   back to the page allocator, so a malloc()/free() loop does not
+   get and free the same page over and over. */
 
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
+	size_t empty_cnt;           /* Arenas with every block free. */
+	size_t mag_cap;             /* Blocks a magazine may hold. */
+	size_t mag_batch;           /* Blocks moved per refill/drain. */
 	struct lock lock;           /* Lock. */
 };
 
+/* Most blocks a magazine can hold. */
+#define MAG_MAX 32
+
+/* Entirely free arenas a descriptor keeps before freeing pages. */
+#define ARENA_KEEP 2
+
+/* Per-CPU stack of free blocks for one descriptor. */
+struct magazine {
+	size_t cnt;                 /* Number of blocks in BLOCKS. */
+	void *blocks[MAG_MAX];      /* Free blocks, most recent last. */
+};
+
 /* Magic number for detecting arena corruption. */
 #define ARENA_MAGIC 0x9a548eed
 
@@ -58,11 +89,26 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+#define DESC_MAX 10
+static struct desc descs[DESC_MAX]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Magazines of every CPU, one per descriptor. */
+struct cpu_magazines {
+	struct magazine mags[DESC_MAX];
+} __attribute__ ((aligned (64)));
+static struct cpu_magazines magazines[CPU_MAX];
+
+/* Whether malloc() and free() go through the magazines and keep
+   free arenas around.  Benchmarks turn this off for comparison. */
+bool malloc_magazines = true;
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static size_t desc_get_blocks (struct desc *, void **, size_t cnt);
+static void desc_put_blocks (struct desc *, void **, size_t cnt);
+static void *magazine_alloc (struct desc *);
+static void magazine_free (struct desc *, struct block *);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -75,6 +121,9 @@ malloc_init (void) {
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
 		list_init (&d->free_list);
+		d->empty_cnt = 0;
+		d->mag_cap = d->blocks_per_arena < MAG_MAX ? d->blocks_per_arena : MAG_MAX;
+		d->mag_batch = (d->mag_cap + 1) / 2;
 		lock_init (&d->lock);
 	}
 }
@@ -112,35 +161,9 @@ malloc (size_t size) {
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
-
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
-	}
-
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
-	return b;
+	if (malloc_magazines)
+		return magazine_alloc (d);
+	return desc_get_blocks (d, (void **) &b, 1) > 0 ? b : NULL;
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -213,24 +236,10 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
-			}
-
-			lock_release (&d->lock);
+			if (malloc_magazines)
+				magazine_free (d, b);
+			else
+				desc_put_blocks (d, (void **) &b, 1);
 		} else {
 			/* It's a big block.  Free its pages. */
 			palloc_free_multiple (a, a->free_cnt);
@@ -266,3 +275,158 @@ arena_to_block (struct arena *a, size_t idx) {
 			+ sizeof *a
 			+ idx * a->desc->block_size);
 }
+
+/* Takes up to CNT free blocks from D's free list and stores them
+   in BLOCKS, creating a new arena first if the list is empty.
+   Returns the number of blocks taken, which is 0 only if memory
+   is not available. */
+static size_t
+desc_get_blocks (struct desc *d, void **blocks, size_t cnt) {
+	size_t got = 0;
+
+	lock_acquire (&d->lock);
+
+	/* If the free list is empty, create a new arena. */
+	if (list_empty (&d->free_list)) {
+		struct arena *a;
+		size_t i;
+
+		/* Allocate a page. */
+		a = palloc_get_page (0);
+		if (a == NULL) {
+			lock_release (&d->lock);
+			return 0;
+		}
+
+		/* Initialize arena and add its blocks to the free list. */
+		a->magic = ARENA_MAGIC;
+		a->desc = d;
+		a->free_cnt = d->blocks_per_arena;
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_push_back (&d->free_list, &b->free_elem);
+		}
+		d->empty_cnt++;
+	}
+
+	/* Get blocks from free list. */
+	while (got < cnt && !list_empty (&d->free_list)) {
+		struct block *b = list_entry (list_pop_front (&d->free_list),
+				struct block, free_elem);
+		struct arena *a = block_to_arena (b);
+
+		if (a->free_cnt-- == d->blocks_per_arena)
+			d->empty_cnt--;
+		blocks[got++] = b;
+	}
+
+	lock_release (&d->lock);
+	return got;
+}
+
+/* Returns the CNT blocks in BLOCKS to D's free list.  An arena
+   that becomes entirely free is kept if D has fewer than
+   ARENA_KEEP such arenas, and given back to the page allocator
+   otherwise. */
+static void
+desc_put_blocks (struct desc *d, void **blocks, size_t cnt) {
+	size_t keep = malloc_magazines ? ARENA_KEEP : 0;
+	size_t i;
+
+	lock_acquire (&d->lock);
+	for (i = 0; i < cnt; i++) {
+		struct block *b = blocks[i];
+		struct arena *a = block_to_arena (b);
+
+		/* Add block to free list. */
+		list_push_front (&d->free_list, &b->free_elem);
+
+		/* If the arena is now entirely unused, keep or free it. */
+		if (++a->free_cnt >= d->blocks_per_arena) {
+			size_t j;
+
+			ASSERT (a->free_cnt == d->blocks_per_arena);
+			if (d->empty_cnt < keep) {
+				d->empty_cnt++;
+				continue;
+			}
+			for (j = 0; j < d->blocks_per_arena; j++) {
+				struct block *b = arena_to_block (a, j);
+				list_remove (&b->free_elem);
+			}
+			palloc_free_page (a);
+		}
+	}
+	lock_release (&d->lock);
+}
+
+/* Returns the running CPU's magazine for D.
+   Interrupts must be off. */
+static struct magazine *
+this_magazine (struct desc *d) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return &magazines[this_cpu ()->id].mags[d - descs];
+}
+
+/* Allocates a block from D through the running CPU's magazine,
+   refilling the magazine from D if it is empty.
+   Returns a null pointer if memory is not available. */
+static void *
+magazine_alloc (struct desc *d) {
+	void *blocks[MAG_MAX / 2];
+	enum intr_level old_level;
+	struct magazine *m;
+	void *b = NULL;
+	size_t got, i;
+
+	/* Fast path: pop from this CPU's magazine, no lock needed. */
+	old_level = intr_disable ();
+	m = this_magazine (d);
+	if (m->cnt > 0)
+		b = m->blocks[--m->cnt];
+	intr_set_level (old_level);
+	if (b != NULL)
+		return b;
+
+	/* Refill with a batch from the descriptor.  We may sleep on
+	   D's lock and wake up on another CPU, so look the magazine
+	   up again and give back whatever no longer fits. */
+	got = desc_get_blocks (d, blocks, d->mag_batch);
+	if (got == 0)
+		return NULL;
+
+	old_level = intr_disable ();
+	m = this_magazine (d);
+	for (i = 1; i < got && m->cnt < d->mag_cap; i++)
+		m->blocks[m->cnt++] = blocks[i];
+	intr_set_level (old_level);
+	if (i < got)
+		desc_put_blocks (d, blocks + i, got - i);
+	return blocks[0];
+}
+
+/* Frees block B of descriptor D into the running CPU's magazine.
+   If the magazine is full, its oldest batch of blocks goes back
+   to D first. */
+static void
+magazine_free (struct desc *d, struct block *b) {
+	void *blocks[MAG_MAX / 2];
+	enum intr_level old_level;
+	struct magazine *m;
+	size_t cnt = 0;
+
+	old_level = intr_disable ();
+	m = this_magazine (d);
+	if (m->cnt >= d->mag_cap) {
+		cnt = d->mag_batch;
+		memcpy (blocks, m->blocks, cnt * sizeof *blocks);
+		memmove (m->blocks, m->blocks + cnt,
+				(m->cnt - cnt) * sizeof *m->blocks);
+		m->cnt -= cnt;
+	}
+	m->blocks[m->cnt++] = b;
+	intr_set_level (old_level);
+
+	if (cnt > 0)
+		desc_put_blocks (d, blocks, cnt);
+}
@@ -1,6 +1,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
@@ -203,6 +204,9 @@ pml4_destroy (uint64_t *pml4) {
  * register. */
 void
 pml4_activate (uint64_t *pml4) {
+	/* NOTE: [Improve] Remember which page table this CPU uses, so that
+	   cpu_tlb_invalidate () knows whom to send a TLB shootdown. */
+	this_cpu ()->pml4 = pml4 ? pml4 : base_pml4;
 	lcr3 (vtop (pml4 ? pml4 : base_pml4));
 }
 
@@ -257,8 +261,7 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		cpu_tlb_invalidate (pml4, upage);
 	}
 }
 
@@ -283,8 +286,7 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		cpu_tlb_invalidate (pml4, vpage);
 	}
 }
 
@@ -309,7 +311,22 @@ pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		cpu_tlb_invalidate (pml4, vpage);
+	}
+}
+
+/* NOTE: [Improve] Sets the writable bit to WRITABLE in the PTE for
+ * present virtual page VPAGE in PML4, leaving the mapping itself
+ * alone.  Used by copy-on-write fork to write-protect shared frames. */
+void
+pml4_set_writable (uint64_t *pml4, const void *vpage, bool writable) {
+	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	if (pte != NULL && (*pte & PTE_P) != 0) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t) PTE_W;
+
+		cpu_tlb_invalidate (pml4, vpage);
 	}
 }
@@ -2,14 +2,18 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,7 +28,72 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   NOTE: [Improve] Each pool is managed by a binary buddy
+   allocator.  A free block of order K is 2**K pages long and
+   starts at a page index (relative to the pool base) that is a
+   multiple of 2**K.  Free blocks sit on per-order free lists,
+   linked through their first page, and ORDER_MAP remembers
+   which pages head a free block and of what order.
+
+   A request for N pages takes a block of the smallest order K
+   with 2**K >= N, splitting a larger block if needed, and gives
+   the 2**K - N unused tail pages back.  Freeing a run splits it
+   into aligned blocks and merges each one with its buddy for as
+   long as the buddy is free too.  Both are O(log n).  USED_MAP
+   still records allocated pages for sanity checks.
+
+   NOTE: [Improve] Single pages go through a per-CPU page cache
+   in front of the buddy allocator.  Each CPU keeps, per pool, a
+   stack of free pages whose top is the most recently freed (and
+   so most likely cache-hot) page, and a separate stack of pages
+   known to be all zeros.  The caches are only touched by their
+   own CPU with interrupts off, so the common path takes no lock.
+   An empty cache is refilled with PCP_BATCH pages in one buddy
+   call; a full one returns its PCP_BATCH coldest pages.  Pages in
+   a cache still count as allocated in USED_MAP.
+
+   NOTE: [Improve] A PRI_MIN kernel thread, the zeroer, takes free
+   pages from the buddy allocator while nothing else wants to run,
+   clears them and keeps up to ZERO_POOL_MAX of them per pool.  A
+   PAL_ZERO request for a single page that finds no zeroed page in
+   its CPU cache takes a batch from this pool instead of clearing a
+   page itself.  The zeroer is woken when a pool drops below
+   ZERO_POOL_LOW, and the pool is given back to the buddy allocator
+   whenever memory runs short.  The zeroer is a background thread,
+   so it does not count towards the MLFQS load_avg.
+
+   Multi-page PAL_ZERO requests (the fd table, the frame table)
+   are out of scope: the zeroed pool holds unrelated single pages,
+   not contiguous runs, so those requests clear their pages inline
+   and are counted apart from the single-page misses. */
+
+/* Largest block order: 2**BUDDY_MAX_ORDER pages. */
+#define BUDDY_MAX_ORDER 18
+
+/* Pages moved per refill or drain of a per-CPU cache. */
+#define PCP_BATCH 16
+
+/* Most pages a per-CPU cache list holds. */
+#define PCP_HIGH 32
+
+/* Pre-zeroed pages the zeroer keeps per pool, and the level
+   below which it is woken up. */
+#define ZERO_POOL_MAX 64
+#define ZERO_POOL_LOW 32
+
+/* Zeroed pages moved from a pool into a CPU cache at once. */
+#define ZERO_BATCH 8
+
+/* Per-CPU page cache of one pool. */
+struct pcp
+{
+	size_t cnt;					/* Number of pages in PAGES. */
+	void *pages[PCP_HIGH];		/* Free pages, hottest last. */
+	size_t zero_cnt;			/* Number of pages in ZERO_PAGES. */
+	void *zero_pages[PCP_HIGH]; /* Free pages known to be zeroed. */
+} __attribute__((aligned(64)));
 
 /* A memory pool. */
 struct pool
@@ -32,6 +101,25 @@ struct pool
 	struct lock lock;		 /* Mutual exclusion. */
 	struct bitmap *used_map; /* Bitmap of free pages. */
 	uint8_t *base;			 /* Base of pool. */
+	size_t page_cnt;		 /* Number of pages in pool. */
+
+	/* Buddy allocator. */
+	struct list free_lists[BUDDY_MAX_ORDER + 1]; /* Free blocks by order. */
+	uint8_t *order_map;		 /* Per page: order + 1 if it heads a free
+								block, 0 otherwise. */
+	size_t free_cnt;		 /* Number of free pages. */
+
+	struct pcp pcps[CPU_MAX]; /* Per-CPU page caches. */
+
+	/* Pages cleared by the zeroer, protected by LOCK. */
+	void *zero_pool[ZERO_POOL_MAX];
+	size_t zero_pool_cnt;
+};
+
+/* Header of a free buddy block, stored in its first page. */
+struct buddy_block
+{
+	struct list_elem elem; /* Element in pool's free list. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -43,6 +131,30 @@ static void
 init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool(const struct pool *, void *page);
+static void init_buddy(struct pool *);
+static size_t buddy_alloc(struct pool *, size_t page_cnt);
+static void buddy_free(struct pool *, size_t page_idx, size_t page_cnt);
+static struct pool *page_pool(void *page);
+static void *pool_get(struct pool *, size_t page_cnt);
+static void pool_put(struct pool *, void **pages, size_t cnt);
+static void *pcp_get(struct pool *, bool zero, bool *zeroed);
+static void pcp_put(struct pool *, void *page);
+#ifndef NDEBUG
+static bool pcp_holds(struct pcp *, void *page);
+#endif
+static size_t zero_pool_take(struct pool *, void **pages, size_t cnt);
+static bool zero_pool_release(struct pool *);
+
+/* NOTE: [Improve] Zeroer thread state. */
+static struct semaphore zero_sema; /* Upped to wake the zeroer. */
+static bool zeroer_sleeping;	   /* Zeroer is waiting on ZERO_SEMA. */
+
+/* PAL_ZERO single-page requests served with a page that was
+   already zeroed, and ones that had to clear it inline, and
+   multi-page PAL_ZERO requests, which are always cleared inline. */
+static uint64_t zero_hits;
+static uint64_t zero_misses;
+static uint64_t zero_multi;
 
 /* multiboot info */
 struct multiboot_info
@@ -281,6 +393,9 @@ palloc_init(void)
 	printf("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		   ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools(&base_mem, &ext_mem);
+	init_buddy(&kernel_pool);
+	init_buddy(&user_pool);
+	sema_init(&zero_sema, 0);
 	return ext_mem.end;
 }
 
@@ -294,21 +409,38 @@ void *
 palloc_get_multiple(enum palloc_flags flags, size_t page_cnt)
 {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire(&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-	lock_release(&pool->lock);
+	bool zeroed = false;
 	void *pages;
 
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
+	if (page_cnt == 0)
+		return NULL;
+
+	/* NOTE: [Improve] Single pages come from the per-CPU cache,
+	   runs straight from the buddy allocator. */
+	if (page_cnt == 1)
+		pages = pcp_get(pool, (flags & PAL_ZERO) != 0, &zeroed);
 	else
-		pages = NULL;
+	{
+		pages = pool_get(pool, page_cnt);
+		if (pages == NULL && zero_pool_release(pool))
+			pages = pool_get(pool, page_cnt);
+	}
 
 	if (pages)
 	{
 		if (flags & PAL_ZERO)
-			memset(pages, 0, PGSIZE * page_cnt);
+		{
+			if (zeroed)
+				zero_hits++;
+			else
+			{
+				if (page_cnt == 1)
+					zero_misses++;
+				else
+					zero_multi++;
+				memset(pages, 0, PGSIZE * page_cnt);
+			}
+		}
 	}
 	else
 	{
@@ -342,20 +474,56 @@ void palloc_free_multiple(void *pages, size_t page_cnt)
 	if (pages == NULL || page_cnt == 0)
 		return;
 
-	if (page_from_pool(&kernel_pool, pages))
-		pool = &kernel_pool;
-	else if (page_from_pool(&user_pool, pages))
-		pool = &user_pool;
-	else
-		NOT_REACHED();
-
-	page_idx = pg_no(pages) - pg_no(pool->base);
+	pool = page_pool(pages);
 
 #ifndef NDEBUG
 	memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
+
+	/* NOTE: [Improve] Single pages go back to the per-CPU cache. */
+	if (page_cnt == 1)
+	{
+		pcp_put(pool, pages);
+		return;
+	}
+
+	page_idx = pg_no(pages) - pg_no(pool->base);
+	lock_acquire(&pool->lock);
 	ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+	buddy_free(pool, page_idx, page_cnt);
+	lock_release(&pool->lock);
+}
+
+/* NOTE: [Improve] Returns every page held in the per-CPU caches and
+   the zeroed pools to the buddy allocator.  The caches of other CPUs are only touched
+   by kernel code, so the big kernel lock keeps them still. */
+void palloc_drain_caches(void)
+{
+	struct pool *pools[] = {&kernel_pool, &user_pool};
+	size_t i;
+	int c;
+
+	ASSERT(kernel_lock_held());
+
+	for (i = 0; i < sizeof pools / sizeof *pools; i++)
+		for (c = 0; c < CPU_MAX; c++)
+		{
+			struct pcp *pcp = &pools[i]->pcps[c];
+			enum intr_level old_level = intr_disable();
+			void *pages[PCP_HIGH], *zero_pages[PCP_HIGH];
+			size_t cnt = pcp->cnt, zero_cnt = pcp->zero_cnt;
+
+			memcpy(pages, pcp->pages, cnt * sizeof *pages);
+			memcpy(zero_pages, pcp->zero_pages, zero_cnt * sizeof *zero_pages);
+			pcp->cnt = pcp->zero_cnt = 0;
+			intr_set_level(old_level);
+
+			pool_put(pools[i], pages, cnt);
+			pool_put(pools[i], zero_pages, zero_cnt);
+		}
+	for (i = 0; i < sizeof pools / sizeof *pools; i++)
+		zero_pool_release(pools[i]);
 }
 
 /* Frees the page at PAGE. */
@@ -364,6 +532,18 @@ void palloc_free_page(void *page)
 	palloc_free_multiple(page, 1);
 }
 
+/* NOTE: [Improve] Returns the pool that PAGE belongs to. */
+static struct pool *
+page_pool(void *page)
+{
+	if (page_from_pool(&kernel_pool, page))
+		return &kernel_pool;
+	else if (page_from_pool(&user_pool, page))
+		return &user_pool;
+	else
+		NOT_REACHED();
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end)
@@ -373,15 +553,28 @@ init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end)
 	   and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+	size_t om_pages = DIV_ROUND_UP(pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
 	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
 	p->base = (void *)start;
+	p->page_cnt = pgcnt;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
 
 	*bm_base += bm_pages;
+
+	/* NOTE: [Improve] The buddy order map follows the bitmap.
+	   Free lists stay empty until init_buddy(). */
+	p->order_map = *bm_base;
+	memset(p->order_map, 0, om_pages);
+	for (order = 0; order <= BUDDY_MAX_ORDER; order++)
+		list_init(&p->free_lists[order]);
+	p->free_cnt = 0;
+
+	*bm_base += om_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -394,3 +587,462 @@ page_from_pool(const struct pool *pool, void *page)
 	size_t end_page = start_page + bitmap_size(pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* NOTE: [Improve] Hands every page that populate_pools() marked
+   usable in POOL's bitmap over to the buddy allocator. */
+static void
+init_buddy(struct pool *pool)
+{
+	size_t idx = 0;
+
+	while (idx < pool->page_cnt)
+	{
+		size_t end;
+
+		if (bitmap_test(pool->used_map, idx))
+		{
+			idx++;
+			continue;
+		}
+		end = bitmap_scan(pool->used_map, idx, 1, true);
+		if (end == BITMAP_ERROR)
+			end = pool->page_cnt;
+		buddy_free(pool, idx, end - idx);
+		idx = end;
+	}
+}
+
+/* Returns the page index of BLOCK within POOL. */
+static size_t
+block_idx(const struct pool *pool, struct buddy_block *block)
+{
+	return ((uint8_t *)block - pool->base) / PGSIZE;
+}
+
+/* Returns the free block header in the page at IDX. */
+static struct buddy_block *
+idx_block(const struct pool *pool, size_t idx)
+{
+	return (struct buddy_block *)(pool->base + idx * PGSIZE);
+}
+
+/* Puts the free block of order ORDER at IDX on its free list. */
+static void
+push_block(struct pool *pool, size_t idx, int order)
+{
+	list_push_front(&pool->free_lists[order], &idx_block(pool, idx)->elem);
+	pool->order_map[idx] = order + 1;
+}
+
+/* Takes the free block of order ORDER at IDX off its free list. */
+static void
+remove_block(struct pool *pool, size_t idx, int order)
+{
+	ASSERT(pool->order_map[idx] == order + 1);
+	list_remove(&idx_block(pool, idx)->elem);
+	pool->order_map[idx] = 0;
+}
+
+/* Frees the block of order ORDER at IDX, merging it with its
+   buddy as long as the buddy is a free block of the same
+   order. */
+static void
+free_block(struct pool *pool, size_t idx, int order)
+{
+	while (order < BUDDY_MAX_ORDER)
+	{
+		size_t buddy = idx ^ ((size_t)1 << order);
+
+		if (buddy + ((size_t)1 << order) > pool->page_cnt || pool->order_map[buddy] != order + 1)
+			break;
+		remove_block(pool, buddy, order);
+		if (buddy < idx)
+			idx = buddy;
+		order++;
+	}
+	push_block(pool, idx, order);
+}
+
+/* Returns PAGE_CNT pages starting at IDX to POOL.  The run is cut
+   into the largest aligned blocks it contains, and each one is
+   freed and merged with its buddy. */
+static void
+buddy_free(struct pool *pool, size_t idx, size_t page_cnt)
+{
+	pool->free_cnt += page_cnt;
+	while (page_cnt > 0)
+	{
+		int order = 0;
+
+		while (order < BUDDY_MAX_ORDER && (idx & ((size_t)1 << order)) == 0 && ((size_t)2 << order) <= page_cnt)
+			order++;
+		free_block(pool, idx, order);
+		idx += (size_t)1 << order;
+		page_cnt -= (size_t)1 << order;
+	}
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first one, or BITMAP_ERROR if no block is large
+   enough.  POOL's lock must be held. */
+static size_t
+buddy_alloc(struct pool *pool, size_t page_cnt)
+{
+	struct buddy_block *block;
+	int order = 0, k;
+	size_t idx;
+
+	while (((size_t)1 << order) < page_cnt)
+		if (++order > BUDDY_MAX_ORDER)
+			return BITMAP_ERROR;
+
+	/* Find the smallest non-empty free list of at least ORDER. */
+	for (k = order; k <= BUDDY_MAX_ORDER; k++)
+		if (!list_empty(&pool->free_lists[k]))
+			break;
+	if (k > BUDDY_MAX_ORDER)
+		return BITMAP_ERROR;
+
+	block = list_entry(list_front(&pool->free_lists[k]), struct buddy_block, elem);
+	idx = block_idx(pool, block);
+	remove_block(pool, idx, k);
+
+	/* Split it down to ORDER, freeing the upper halves. */
+	while (k > order)
+	{
+		k--;
+		push_block(pool, idx + ((size_t)1 << k), k);
+	}
+	pool->free_cnt -= (size_t)1 << order;
+
+	/* Give back the unused tail. */
+	if (page_cnt < ((size_t)1 << order))
+		buddy_free(pool, idx + page_cnt, ((size_t)1 << order) - page_cnt);
+	return idx;
+}
+
+/* NOTE: [Improve] Allocates PAGE_CNT contiguous pages from the
+   buddy allocator of POOL.  Returns a null pointer on failure. */
+static void *
+pool_get(struct pool *pool, size_t page_cnt)
+{
+	size_t page_idx;
+
+	lock_acquire(&pool->lock);
+	page_idx = buddy_alloc(pool, page_cnt);
+	if (page_idx != BITMAP_ERROR)
+	{
+		ASSERT(bitmap_none(pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+	}
+	lock_release(&pool->lock);
+
+	return page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+}
+
+/* NOTE: [Improve] Returns the CNT single pages in PAGES to the
+   buddy allocator of POOL under one lock acquisition. */
+static void
+pool_put(struct pool *pool, void **pages, size_t cnt)
+{
+	size_t i;
+
+	if (cnt == 0)
+		return;
+
+	lock_acquire(&pool->lock);
+	for (i = 0; i < cnt; i++)
+	{
+		size_t page_idx = pg_no(pages[i]) - pg_no(pool->base);
+
+		ASSERT(bitmap_test(pool->used_map, page_idx));
+		bitmap_reset(pool->used_map, page_idx);
+		buddy_free(pool, page_idx, 1);
+	}
+	lock_release(&pool->lock);
+}
+
+/* NOTE: [Improve] Returns the running CPU's cache of POOL.
+   Interrupts must be off. */
+static struct pcp *
+this_pcp(struct pool *pool)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	return &pool->pcps[this_cpu()->id];
+}
+
+#ifndef NDEBUG
+/* NOTE: [Improve] Returns true if PAGE is in cache PCP. */
+static bool
+pcp_holds(struct pcp *pcp, void *page)
+{
+	size_t i;
+
+	for (i = 0; i < pcp->cnt; i++)
+		if (pcp->pages[i] == page)
+			return true;
+	for (i = 0; i < pcp->zero_cnt; i++)
+		if (pcp->zero_pages[i] == page)
+			return true;
+	return false;
+}
+#endif
+
+/* NOTE: [Improve] Takes a single page from the running CPU's
+   cache of POOL, refilling the cache from the buddy allocator if
+   it is empty.  With ZERO, a zeroed page is preferred; otherwise
+   zeroed pages are used only when no other page is cached.  Sets
+   *ZEROED to true if the returned page is known to be zeroed.
+   Returns a null pointer if memory is not available. */
+static void *
+pcp_get(struct pool *pool, bool zero, bool *zeroed)
+{
+	void *batch[PCP_BATCH];
+	enum intr_level old_level;
+	struct pcp *pcp;
+	void *page = NULL;
+	size_t got = 0, i;
+
+	*zeroed = false;
+	old_level = intr_disable();
+	pcp = this_pcp(pool);
+	if (pcp->zero_cnt > 0 && (zero || pcp->cnt == 0))
+	{
+		page = pcp->zero_pages[--pcp->zero_cnt];
+		*zeroed = true;
+	}
+	else if (pcp->cnt > 0 && !zero)
+		page = pcp->pages[--pcp->cnt];
+	intr_set_level(old_level);
+	if (page != NULL)
+		return page;
+
+	/* A PAL_ZERO request with no zeroed page cached takes a batch
+	   from the zeroer's pool, keeping the rest on this CPU. */
+	if (zero && (got = zero_pool_take(pool, batch, ZERO_BATCH)) > 0)
+	{
+		old_level = intr_disable();
+		pcp = this_pcp(pool);
+		for (i = 1; i < got && pcp->zero_cnt < PCP_HIGH; i++)
+			pcp->zero_pages[pcp->zero_cnt++] = batch[i];
+		intr_set_level(old_level);
+		pool_put(pool, batch + i, got - i);
+		*zeroed = true;
+		return batch[0];
+	}
+
+	old_level = intr_disable();
+	pcp = this_pcp(pool);
+	if (pcp->cnt > 0)
+		page = pcp->pages[--pcp->cnt];
+	intr_set_level(old_level);
+	if (page != NULL)
+		return page;
+
+	/* Refill with PCP_BATCH pages, in one block if possible. */
+	page = pool_get(pool, PCP_BATCH);
+	if (page != NULL)
+		for (; got < PCP_BATCH; got++)
+			batch[got] = (uint8_t *)page + PGSIZE * got;
+	else
+		while (got < PCP_BATCH && (page = pool_get(pool, 1)) != NULL)
+			batch[got++] = page;
+	if (got == 0)
+	{
+		/* Out of free pages: fall back on a pre-zeroed one. */
+		if (zero_pool_take(pool, &page, 1) == 0)
+			return NULL;
+		*zeroed = true;
+		return page;
+	}
+
+	/* We may have slept on the pool lock and moved to another CPU,
+	   so look the cache up again and give back what does not fit. */
+	old_level = intr_disable();
+	pcp = this_pcp(pool);
+	for (i = 1; i < got && pcp->cnt < PCP_HIGH; i++)
+		pcp->pages[pcp->cnt++] = batch[i];
+	intr_set_level(old_level);
+	pool_put(pool, batch + i, got - i);
+	return batch[0];
+}
+
+/* NOTE: [Improve] Puts single PAGE into the running CPU's cache
+   of POOL.  A full cache first returns its PCP_BATCH coldest pages
+   to the buddy allocator. */
+static void
+pcp_put(struct pool *pool, void *page)
+{
+	void *batch[PCP_BATCH];
+	enum intr_level old_level;
+	struct pcp *pcp;
+	size_t cnt = 0;
+
+	/* Catch double frees: the page must still be allocated, and
+	   must not already sit in this CPU's cache.  (A page in another
+	   CPU's cache also counts as allocated, so a double free across
+	   CPUs is only caught once both copies reach the buddy
+	   allocator.)  Only the owner of an allocated page changes its
+	   bit, so reading it without the pool lock is safe. */
+	ASSERT(bitmap_test(pool->used_map, pg_no(page) - pg_no(pool->base)));
+
+	old_level = intr_disable();
+	pcp = this_pcp(pool);
+	ASSERT(!pcp_holds(pcp, page));
+	if (pcp->cnt >= PCP_HIGH)
+	{
+		cnt = PCP_BATCH;
+		memcpy(batch, pcp->pages, cnt * sizeof *batch);
+		memmove(pcp->pages, pcp->pages + cnt,
+				(pcp->cnt - cnt) * sizeof *pcp->pages);
+		pcp->cnt -= cnt;
+	}
+	pcp->pages[pcp->cnt++] = page;
+	intr_set_level(old_level);
+
+	pool_put(pool, batch, cnt);
+}
+
+/* NOTE: [Improve] Wakes the zeroer if it is waiting for work. */
+static void
+zeroer_wake(void)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (zeroer_sleeping)
+	{
+		zeroer_sleeping = false;
+		sema_up(&zero_sema);
+	}
+	intr_set_level(old_level);
+}
+
+/* NOTE: [Improve] Takes up to CNT pages from the zeroed pool of
+   POOL into PAGES and returns how many were taken.  Wakes the
+   zeroer if the pool runs low. */
+static size_t
+zero_pool_take(struct pool *pool, void **pages, size_t cnt)
+{
+	bool low;
+
+	lock_acquire(&pool->lock);
+	if (cnt > pool->zero_pool_cnt)
+		cnt = pool->zero_pool_cnt;
+	pool->zero_pool_cnt -= cnt;
+	memcpy(pages, pool->zero_pool + pool->zero_pool_cnt, cnt * sizeof *pages);
+	low = pool->zero_pool_cnt < ZERO_POOL_LOW;
+	lock_release(&pool->lock);
+
+	if (low)
+		zeroer_wake();
+	return cnt;
+}
+
+/* NOTE: [Improve] Gives every page in the zeroed pool of POOL back
+   to the buddy allocator.  Returns true if there were any. */
+static bool
+zero_pool_release(struct pool *pool)
+{
+	void *pages[ZERO_POOL_MAX];
+	size_t cnt;
+
+	lock_acquire(&pool->lock);
+	cnt = pool->zero_pool_cnt;
+	memcpy(pages, pool->zero_pool, cnt * sizeof *pages);
+	pool->zero_pool_cnt = 0;
+	lock_release(&pool->lock);
+
+	pool_put(pool, pages, cnt);
+	return cnt > 0;
+}
+
+/* NOTE: [Improve] Clears one free page of POOL and adds it to the
+   zeroed pool.  Returns false, doing nothing, if the zeroed pool
+   is full or the pool is too short of free pages to spare one. */
+static bool
+zero_one(struct pool *pool)
+{
+	size_t page_idx;
+	void *page;
+
+	lock_acquire(&pool->lock);
+	if (pool->zero_pool_cnt >= ZERO_POOL_MAX || pool->free_cnt <= ZERO_POOL_MAX)
+	{
+		lock_release(&pool->lock);
+		return false;
+	}
+	page_idx = buddy_alloc(pool, 1);
+	ASSERT(page_idx != BITMAP_ERROR);
+	bitmap_mark(pool->used_map, page_idx);
+	lock_release(&pool->lock);
+
+	page = pool->base + PGSIZE * page_idx;
+	memset(page, 0, PGSIZE);
+
+	lock_acquire(&pool->lock);
+	if (pool->zero_pool_cnt < ZERO_POOL_MAX)
+	{
+		pool->zero_pool[pool->zero_pool_cnt++] = page;
+		page = NULL;
+	}
+	lock_release(&pool->lock);
+
+	if (page != NULL)
+		pool_put(pool, &page, 1);
+	return true;
+}
+
+/* NOTE: [Improve] Body of the zeroer thread.  Clears one page per
+   pool per round and yields in between, so it only uses CPU time
+   nothing else wants.  Sleeps once both pools are full. */
+static void
+zeroer(void *aux UNUSED)
+{
+	thread_set_background();
+
+	for (;;)
+	{
+		bool worked = zero_one(&kernel_pool);
+
+		if (zero_one(&user_pool))
+			worked = true;
+
+		if (worked)
+			thread_yield();
+		else
+		{
+			enum intr_level old_level = intr_disable();
+			zeroer_sleeping = true;
+			sema_down(&zero_sema);
+			intr_set_level(old_level);
+		}
+	}
+}
+
+/* NOTE: [Improve] Starts the zeroer thread.  Needs the scheduler
+   to be running. */
+void palloc_start_zeroer(void)
+{
+	thread_create("zeroer", PRI_MIN, zeroer, NULL);
+}
+
+/* NOTE: [Improve] Prints statistics about the zeroed pools. */
+void palloc_print_stats(void)
+{
+	printf("Palloc: %llu zeroed-page hits, %llu misses, %llu multi-page, %zu+%zu pages pre-zeroed\n",
+		   zero_hits, zero_misses, zero_multi, kernel_pool.zero_pool_cnt, user_pool.zero_pool_cnt);
+}
+/* NOTE: [Improve] Returns the number of pages in the user pool. */
+size_t palloc_user_page_cnt(void)
+{
+	return user_pool.page_cnt;
+}
+
+/* NOTE: [Improve] Returns the index of user PAGE within the user
+   pool, so callers can keep per-frame data in a flat array. */
+size_t palloc_user_page_idx(void *page)
+{
+	ASSERT(page_from_pool(&user_pool, page));
+	ASSERT(pg_ofs(page) == 0);
+	return pg_no(page) - pg_no(user_pool.base);
+}
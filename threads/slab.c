@@ -0,0 +1,252 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* NOTE: [Improve] Slab allocator.
+
+   cache마다 한 페이지짜리 slab을 여러 개 가진다.  slab 페이지의 맨 앞에는
+   struct slab 헤더와 빈 칸 비트맵이 있고, 그 뒤로 같은 크기의 객체가
+   빈틈없이 놓인다.  비트맵의 비트가 1이면 빈 칸이다.
+
+   할당은 partial -> empty 순으로 slab을 고르고, 둘 다 없으면 새 페이지를
+   받아 slab을 만든다.  해제한 객체의 slab은 pg_round_down()으로 바로 찾는다.
+   모두 빈 slab은 SLAB_EMPTY_MAX개까지만 남겨두고 나머지는 페이지 할당기로
+   돌려준다.
+
+   생성자(ctor)는 slab을 만들 때 그 안의 모든 객체에 한 번씩만 호출된다.
+   따라서 생성자를 쓰는 cache의 객체는 해제하기 전에 생성자가 만든
+   상태로 되돌려 놓아야 한다. */
+
+/* slab 헤더가 망가졌는지 확인하기 위한 값 */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* 남겨둘 빈 slab의 최대 개수 */
+#define SLAB_EMPTY_MAX 1
+
+/* slab 헤더, 한 페이지의 맨 앞에 위치 */
+struct slab
+{
+	unsigned magic;			   /* 항상 SLAB_MAGIC */
+	struct kmem_cache *cache;  /* 이 slab을 가진 cache */
+	struct list_elem elem;	   /* cache의 partial/full/empty 리스트 요소 */
+	size_t free_cnt;		   /* 빈 칸 수 */
+	uint64_t free_map[];	   /* 빈 칸 비트맵 (1 = 빈 칸) */
+};
+
+/* 객체를 N개 담는 slab에서 첫 객체가 놓이는 위치 */
+static size_t
+slab_obj_ofs(size_t n)
+{
+	return sizeof(struct slab) + DIV_ROUND_UP(n, 64) * sizeof(uint64_t);
+}
+
+static struct slab *slab_create(struct kmem_cache *);
+static void slab_destroy(struct slab *);
+
+/** NOTE: [Improve]
+ * @brief SIZE 바이트 객체를 위한 cache를 만드는 함수
+ *
+ * CTOR가 NULL이 아니면 새 slab의 객체마다 한 번씩 호출된다.
+ * 메모리가 부족하면 NULL을 반환한다.
+ */
+struct kmem_cache *
+kmem_cache_create(const char *name, size_t size, void (*ctor)(void *))
+{
+	struct kmem_cache *cache;
+	size_t n;
+
+	ASSERT(size > 0);
+
+	size = ROUND_UP(size, sizeof(uint64_t));
+	ASSERT(slab_obj_ofs(1) + size <= PGSIZE);
+
+	cache = malloc(sizeof *cache);
+	if (cache == NULL)
+		return NULL;
+
+	/* 헤더와 비트맵까지 포함해서 한 페이지에 들어가는 최대 객체 수 */
+	n = (PGSIZE - sizeof(struct slab)) / size;
+	while (slab_obj_ofs(n) + n * size > PGSIZE)
+		n--;
+
+	cache->name = name;
+	cache->obj_size = size;
+	cache->objs_per_slab = n;
+	cache->obj_ofs = slab_obj_ofs(n);
+	cache->ctor = ctor;
+	list_init(&cache->slabs_partial);
+	list_init(&cache->slabs_full);
+	list_init(&cache->slabs_empty);
+	cache->empty_cnt = 0;
+	cache->slab_cnt = 0;
+	cache->active_cnt = 0;
+	lock_init(&cache->lock);
+	return cache;
+}
+
+/* NOTE: [Improve] CACHE와 그 slab을 모두 해제. 사용 중인 객체가 없어야 한다 */
+void kmem_cache_destroy(struct kmem_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	ASSERT(cache->active_cnt == 0);
+	ASSERT(list_empty(&cache->slabs_partial));
+	ASSERT(list_empty(&cache->slabs_full));
+
+	while (!list_empty(&cache->slabs_empty))
+		slab_destroy(list_entry(list_pop_front(&cache->slabs_empty),
+								struct slab, elem));
+	free(cache);
+}
+
+/** NOTE: [Improve]
+ * @brief CACHE에서 객체 하나를 할당받는 함수
+ *
+ * partial slab을 먼저 쓰고, 없으면 empty slab, 그것도 없으면 새 slab을 만든다.
+ * 메모리가 부족하면 NULL을 반환한다.
+ */
+void *
+kmem_cache_alloc(struct kmem_cache *cache)
+{
+	struct slab *s;
+	size_t word, bit, idx;
+
+	lock_acquire(&cache->lock);
+
+	if (!list_empty(&cache->slabs_partial))
+		s = list_entry(list_front(&cache->slabs_partial), struct slab, elem);
+	else if (!list_empty(&cache->slabs_empty))
+	{
+		s = list_entry(list_pop_front(&cache->slabs_empty), struct slab, elem);
+		cache->empty_cnt--;
+		list_push_front(&cache->slabs_partial, &s->elem);
+	}
+	else
+	{
+		s = slab_create(cache);
+		if (s == NULL)
+		{
+			lock_release(&cache->lock);
+			return NULL;
+		}
+		list_push_front(&cache->slabs_partial, &s->elem);
+	}
+
+	/* 비트맵에서 첫 번째 빈 칸을 찾는다 */
+	for (word = 0; s->free_map[word] == 0; word++)
+		continue;
+	bit = __builtin_ctzll(s->free_map[word]);
+	idx = word * 64 + bit;
+	ASSERT(idx < cache->objs_per_slab);
+
+	s->free_map[word] &= ~(1ULL << bit);
+	cache->active_cnt++;
+
+	/* 마지막 빈 칸이었다면 full 리스트로 */
+	if (--s->free_cnt == 0)
+	{
+		list_remove(&s->elem);
+		list_push_front(&cache->slabs_full, &s->elem);
+	}
+
+	lock_release(&cache->lock);
+	return (uint8_t *)s + cache->obj_ofs + idx * cache->obj_size;
+}
+
+/** NOTE: [Improve]
+ * @brief CACHE에서 받은 객체 OBJ를 돌려주는 함수
+ *
+ * OBJ가 NULL이면 아무 일도 하지 않는다.
+ * slab이 모두 비면 empty 리스트로 옮기고, 빈 slab이 너무 많으면 페이지를 반환한다.
+ */
+void kmem_cache_free(struct kmem_cache *cache, void *obj)
+{
+	struct slab *s;
+	size_t ofs, idx;
+
+	if (obj == NULL)
+		return;
+
+	s = pg_round_down(obj);
+	ASSERT(s->magic == SLAB_MAGIC);
+	ASSERT(s->cache == cache);
+
+	ofs = (uint8_t *)obj - (uint8_t *)s - cache->obj_ofs;
+	idx = ofs / cache->obj_size;
+	ASSERT(ofs % cache->obj_size == 0);
+	ASSERT(idx < cache->objs_per_slab);
+
+	lock_acquire(&cache->lock);
+
+	/* 이중 해제 검사 */
+	ASSERT((s->free_map[idx / 64] & (1ULL << (idx % 64))) == 0);
+	s->free_map[idx / 64] |= 1ULL << (idx % 64);
+	cache->active_cnt--;
+
+	/* full이었다면 partial로 */
+	if (s->free_cnt++ == 0)
+	{
+		list_remove(&s->elem);
+		list_push_front(&cache->slabs_partial, &s->elem);
+	}
+
+	/* 모두 비었다면 empty로, 빈 slab이 너무 많으면 페이지 반환 */
+	if (s->free_cnt == cache->objs_per_slab)
+	{
+		list_remove(&s->elem);
+		if (cache->empty_cnt < SLAB_EMPTY_MAX)
+		{
+			list_push_front(&cache->slabs_empty, &s->elem);
+			cache->empty_cnt++;
+		}
+		else
+			slab_destroy(s);
+	}
+
+	lock_release(&cache->lock);
+}
+
+/* NOTE: [Improve] CACHE를 위한 새 slab 페이지를 만든다. 실패하면 NULL */
+static struct slab *
+slab_create(struct kmem_cache *cache)
+{
+	struct slab *s = palloc_get_page(0);
+	size_t words = DIV_ROUND_UP(cache->objs_per_slab, 64);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = cache;
+	s->free_cnt = cache->objs_per_slab;
+
+	/* 객체 수만큼 비트를 1로, 마지막 word의 남는 비트는 0으로 */
+	for (i = 0; i < words; i++)
+		s->free_map[i] = ~0ULL;
+	if (cache->objs_per_slab % 64 != 0)
+		s->free_map[words - 1] = (1ULL << (cache->objs_per_slab % 64)) - 1;
+
+	if (cache->ctor != NULL)
+		for (i = 0; i < cache->objs_per_slab; i++)
+			cache->ctor((uint8_t *)s + cache->obj_ofs + i * cache->obj_size);
+
+	cache->slab_cnt++;
+	return s;
+}
+
+/* NOTE: [Improve] 리스트에서 빠진 빈 slab S의 페이지를 반환 */
+static void
+slab_destroy(struct slab *s)
+{
+	ASSERT(s->free_cnt == s->cache->objs_per_slab);
+
+	s->cache->slab_cnt--;
+	s->magic = 0;
+	palloc_free_page(s);
+}
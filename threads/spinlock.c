@@ -0,0 +1,70 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/cpu.h"
+#include "intrinsic.h"
+
+/* NOTE: [Improve] LOCK을 NAME이라는 이름의 풀린 spinlock으로 초기화 */
+void spin_lock_init(struct spinlock *lock, const char *name)
+{
+	ASSERT(lock != NULL);
+
+	lock->locked = 0;
+	lock->holder = NULL;
+	lock->old_level = INTR_OFF;
+	lock->name = name;
+}
+
+/** NOTE: [Improve]
+ * @brief 인터럽트를 끄고 LOCK을 잡을 때까지 기다리는 함수
+ *
+ * 같은 CPU에서 다시 잡으면 교착 상태이므로 ASSERT로 막는다.
+ * 기다리는 동안에는 캐시 라인을 읽기만 하다가(test-and-test-and-set)
+ * 풀린 것처럼 보일 때만 xchg를 시도한다.
+ */
+void spin_lock(struct spinlock *lock)
+{
+	enum intr_level old_level = intr_disable();
+
+	ASSERT(!spin_lock_held(lock));
+
+	while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) != 0)
+		while (lock->locked)
+			cpu_relax();
+
+	lock->holder = this_cpu();
+	lock->old_level = old_level;
+}
+
+/* NOTE: [Improve] 기다리지 않고 LOCK을 잡아본다. 성공하면 true */
+bool spin_trylock(struct spinlock *lock)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) != 0)
+	{
+		intr_set_level(old_level);
+		return false;
+	}
+	lock->holder = this_cpu();
+	lock->old_level = old_level;
+	return true;
+}
+
+/* NOTE: [Improve] LOCK을 풀고 spin_lock() 이전의 인터럽트 상태로 되돌린다 */
+void spin_unlock(struct spinlock *lock)
+{
+	enum intr_level old_level = lock->old_level;
+
+	ASSERT(spin_lock_held(lock));
+
+	lock->holder = NULL;
+	__atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+	intr_set_level(old_level);
+}
+
+/* NOTE: [Improve] 현재 CPU가 LOCK을 잡고 있으면 true */
+bool spin_lock_held(const struct spinlock *lock)
+{
+	return lock->locked && lock->holder == this_cpu();
+}
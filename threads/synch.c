@@ -229,7 +229,7 @@ void donate_priority(void)
 		if (!cur->wait_on_lock)
 			break;
 		struct thread *holder = cur->wait_on_lock->holder;
-		holder->priority = cur->priority;
+		thread_change_priority(holder, cur->priority); /* holder가 ready 상태면 ready queue도 옮겨줌 */
 		cur = holder;
 	}
 }
@@ -12,6 +12,11 @@
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #include "threads/fixed_point.h"
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/spinlock.h"
+#include "threads/switch.h"
+#include "threads/fpu.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -25,22 +30,64 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* NOTE: [Part1] 상태가 THREAD_BLOCKED인 쓰레드들의 리스트 */
-static struct list sleep_list;
+/* Lists of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.
+   NOTE: [Improve] 우선순위(PRI_MIN..PRI_MAX)마다 FIFO 큐를 하나씩 두고,
+   비어있지 않은 큐를 ready_bitmap의 비트로 표시한다.
+   삽입/삭제는 O(1), 가장 높은 우선순위 큐는 bsr 한 번으로 찾는다.
+   NOTE: [Improve] SMP: CPU마다 run queue를 따로 두고, 쓰레드는 t->cpu가
+   가리키는 CPU의 run queue에 들어간다. */
+struct run_queue
+{
+	struct spinlock lock;
+	struct list queues[PRI_MAX + 1];
+	uint64_t bitmap; /* i번 비트 = queues[i]가 비어있지 않음 */
+	size_t cnt;		 /* 이 run queue의 ready 쓰레드 수 */
+};
+static struct run_queue run_queues[CPU_MAX];
+static size_t ready_threads_cnt; /* 모든 CPU의 ready 쓰레드 수 (load_avg 계산용) */
+static size_t ready_background_cnt; /* 그중 background 쓰레드 수 (load_avg에서 뺌) */
+
+/* 현재 CPU의 run queue */
+#define this_rq() (&run_queues[this_cpu()->id])
+
+/* T가 자신이 속한 CPU의 idle 쓰레드인지 확인 */
+#define is_idle_thread(t) ((t) == cpus[(t)->cpu].idle_thread)
+
+/* NOTE: [Improve] CPU 간 부하 분산.
+   할 일이 없는 CPU는 가장 바쁜 CPU의 run queue에서 쓰레드를 훔쳐오고(work stealing),
+   BALANCE_INTERVAL tick마다 CPU별 평균 부하(cpu_load_avg)를 비교해 쓰레드를 옮긴다.
+   CACHE_HOT_TICKS 안에 실행된 쓰레드는 캐시가 아직 따뜻하므로 되도록 옮기지 않는다. */
+#define CACHE_HOT_TICKS 2
+static fixed_point cpu_load_avg[CPU_MAX];
+
+/* cpu_load_avg 계산에 쓰이는 가중치 3/4, 1/4 (컴파일 시간 상수) */
+#define CPU_LOAD_WEIGHT_OLD FP_FRAC(3, 4)
+#define CPU_LOAD_WEIGHT_NEW FP_FRAC(1, 4)
+
+/* NOTE: [Improve] 잠든 쓰레드들을 wakeup_tick 기준으로 담는 계층형 타이밍 휠.
+   level 0은 앞으로 256 tick을 tick 단위로, level 1~3은 각각
+   256 * 64^(level-1) tick 단위로 64칸씩 나눈다 (총 2^26 tick 범위).
+   삽입은 O(1)이고, 매 tick에는 level 0의 한 칸만 보면 된다.
+   level 0이 한 바퀴 돌 때마다 상위 level의 한 칸을 아래로 내려보낸다(cascade). */
+#define WHEEL_L0_BITS 8
+#define WHEEL_LN_BITS 6
+#define WHEEL_L0_SIZE (1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE (1 << WHEEL_LN_BITS)
+#define WHEEL_L0_MASK (WHEEL_L0_SIZE - 1)
+#define WHEEL_LN_MASK (WHEEL_LN_SIZE - 1)
+#define WHEEL_UPPER_LEVELS 3
+#define WHEEL_MAX_TICKS (((int64_t)1 << (WHEEL_L0_BITS + WHEEL_UPPER_LEVELS * WHEEL_LN_BITS)) - 1)
+#define WHEEL_LN_SHIFT(level) (WHEEL_L0_BITS + (level) * WHEEL_LN_BITS)
+
+static struct list wheel_l0[WHEEL_L0_SIZE];
+static struct list wheel_ln[WHEEL_UPPER_LEVELS][WHEEL_LN_SIZE];
+static int64_t wheel_tick;	  /* 휠이 다음으로 처리할 tick */
+static size_t sleeping_cnt; /* 휠에 들어있는 쓰레드 수 */
 
 /* NOTE: [Improve] 모든 쓰레드를 담는 리스트 */
 static struct list all_list;
 
-/* 쓰레드들의 wakeup_tick 중 최소값을 저장하는 전역변수 */
-static int64_t global_tick;
-
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
@@ -56,17 +103,41 @@ static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
 
 /* Scheduling. */
-#define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+#define TIME_SLICE 4 /* # of timer ticks to give each thread. */
 
 /* NOTE: [Part3] 시스템 부하 */
 fixed_point load_avg;
 
+/* NOTE: [Improve] 1초마다의 recent_cpu decay를 잠든 쓰레드에게는 나중에 한꺼번에 반영한다.
+   decay_epoch는 지금까지 지난 decay의 수이고, decay_maps[e % DECAY_HISTORY]는
+   epoch e부터 지금까지의 decay를 합친 식 recent_cpu = mul * recent_cpu + add * nice 이다.
+   매초 모든 칸에 그 초의 decay를 곱해 두므로 (O(DECAY_HISTORY)), 밀린 decay가 몇 번이든
+   매초 계산한 것과 같은 값을 O(1)에 얻는다. 칸이 재사용되기 전에 모든 쓰레드를 따라잡게
+   하려고 DECAY_HISTORY / 2초마다 all_list를 한 번 훑는다. */
+#define DECAY_HISTORY 64
+struct decay_map
+{
+	fixed_point mul; /* 그동안의 decay 계수의 곱 */
+	fixed_point add; /* nice에 곱할 계수 */
+};
+static struct decay_map decay_maps[DECAY_HISTORY];
+static int64_t decay_epoch;
+
+/* NOTE: [Improve] load_avg 계산에 쓰이는 가중치 59/60, 1/60 (컴파일 시간 상수) */
+#define LOAD_AVG_WEIGHT_59 FP_FRAC(59, 60)
+#define LOAD_AVG_WEIGHT_1 FP_FRAC(1, 60)
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* NOTE: [Improve] If true, voluntary switches save the whole context into
+   struct intr_frame and resume through do_iret(), as before.  If false
+   (default), they go through switch_threads(), which only keeps the
+   callee-saved registers.  Only switch-bench sets this. */
+bool thread_iret_switch;
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -76,9 +147,20 @@ static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
 
-static int64_t get_min_tick(void);
-static int set_global_tick(int64_t tick);
-static bool wakeup_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
+static void ready_queue_push(struct thread *t);
+static void ready_queue_remove(struct thread *t);
+static int ready_queue_max_priority(struct run_queue *rq);
+static void run_queue_unlink(struct run_queue *rq, struct thread *t);
+static struct thread *run_queue_detach(struct run_queue *rq, bool allow_hot);
+static struct thread *steal_thread(void);
+static size_t cpu_load(int cpu);
+static int select_cpu(struct thread *t);
+static void cpu_preempt_check(int cpu, int priority);
+static int mlfqs_priority(struct thread *t);
+static void mlfqs_refresh(struct thread *t);
+
+static void wheel_insert(struct thread *t);
+static int wheel_cascade(int level);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -124,19 +206,56 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	list_init(&ready_list);
-	list_init(&sleep_list); /* sleep list 초기화 */
-	list_init(&all_list);	/* NOTE: [Improve] all list 초기화 */
+	for (int c = 0; c < CPU_MAX; c++) /* NOTE: [Improve] CPU별, 우선순위별 ready queue 초기화 */
+	{
+		spin_lock_init(&run_queues[c].lock, "run_queue");
+		for (int i = PRI_MIN; i <= PRI_MAX; i++)
+			list_init(&run_queues[c].queues[i]);
+		run_queues[c].bitmap = 0;
+		run_queues[c].cnt = 0;
+	}
+	ready_threads_cnt = 0;
+	for (int i = 0; i < WHEEL_L0_SIZE; i++) /* NOTE: [Improve] 타이밍 휠 초기화 */
+		list_init(&wheel_l0[i]);
+	for (int level = 0; level < WHEEL_UPPER_LEVELS; level++)
+		for (int i = 0; i < WHEEL_LN_SIZE; i++)
+			list_init(&wheel_ln[level][i]);
+	wheel_tick = 0;
+	sleeping_cnt = 0;
+	list_init(&all_list); /* NOTE: [Improve] all list 초기화 */
 	list_init(&destruction_req);
-	v
-		global_tick = INT64_MAX; /* global tick 초기화 */
-	load_avg = int_to_fp(0);	 /* NOTE: [Part3] load_avg 초기화 */
+	load_avg = FP_CONST(0); /* NOTE: [Part3] load_avg 초기화 */
+	decay_maps[0] = (struct decay_map){F, 0}; /* NOTE: [Improve] epoch 0부터 아직 decay 없음 */
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread();
 	init_thread(initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid();
+	this_cpu()->curr = initial_thread;
+}
+
+/** NOTE: [Improve]
+ * @brief AP가 부팅 스택에서 실행 중인 코드를 그 CPU의 idle 쓰레드로 만드는 함수
+ *
+ * AP의 부팅 스택은 페이지 하나이므로 BSP의 thread_init()과 같은 방식으로
+ * 페이지 맨 앞에 struct thread를 만든다. 이후 thread_run_idle()로 들어간다.
+ */
+void thread_init_ap(void)
+{
+	struct cpu *c = this_cpu();
+	struct thread *t = running_thread();
+	char name[16];
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(kernel_lock_held());
+
+	snprintf(name, sizeof name, "idle%d", c->id);
+	init_thread(t, name, PRI_MIN);
+	t->status = THREAD_RUNNING;
+	t->tid = allocate_tid();
+	c->idle_thread = t;
+	c->curr = t;
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -162,7 +281,7 @@ void thread_tick(void)
 	struct thread *t = thread_current();
 
 	/* Update statistics. */
-	if (t == idle_thread)
+	if (is_idle_thread(t))
 		idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
@@ -172,8 +291,21 @@ void thread_tick(void)
 		kernel_ticks++;
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++this_cpu()->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return();
+
+	/* NOTE: [Improve] idle CPU는 다른 CPU에 기다리는 쓰레드가 있으면 훔치러 감 */
+	if (is_idle_thread(t) && cpu_cnt > 1 && ready_threads_cnt > 0)
+		intr_yield_on_return();
+}
+
+/** NOTE: [Improve]
+ * @brief idle one-shot 동안 타이머 인터럽트 없이 지나간 CNT tick을 idle 시간으로 반영하는 함수
+ */
+void thread_add_idle_ticks(int64_t cnt)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	idle_ticks += cnt;
 }
 
 /* Prints thread statistics. */
@@ -243,7 +375,6 @@ tid_t thread_create(const char *name, int priority,
 	t->fdt[1] = 2; /* STDOUT_FILENO: 표준 출력 */
 
 	sema_init(&t->exit_sema, 0);
-	sema_init(&t->load_sema, 0);
 	sema_init(&t->wait_sema, 0);
 	sema_init(&t->fork_sema, 0);
 
@@ -271,6 +402,11 @@ void thread_block(void)
 {
 	ASSERT(!intr_context());
 	ASSERT(intr_get_level() == INTR_OFF);
+
+	/* NOTE: [Improve] MLFQS: 지금까지 쓴 CPU 시간을 반영한 priority로 잠듦 */
+	if (thread_mlfqs && !is_idle_thread(thread_current()))
+		mlfqs_refresh(thread_current());
+
 	thread_current()->status = THREAD_BLOCKED;
 	schedule();
 }
@@ -292,12 +428,23 @@ void thread_unblock(struct thread *t)
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
 
+	/* NOTE: [Improve] MLFQS: 잠든 동안 밀린 recent_cpu decay와 priority를 지금 반영 */
+	if (thread_mlfqs && !is_idle_thread(t))
+		mlfqs_refresh(t);
+
 	/**
-	 * NOTE: ready_list에 우선순위 순으로 삽입
+	 * NOTE: [Improve] 실행할 CPU를 고르고, 그 CPU에서 우선순위에 해당하는
+	 * ready queue의 맨 뒤에 삽입 (O(1))
 	 * part: priority-insert-ordered
 	 */
-	list_insert_ordered(&ready_list, &t->elem, compare_priority, NULL);
+	if (!is_idle_thread(t))
+		t->cpu = select_cpu(t);
+	ready_queue_push(t);
 	t->status = THREAD_READY;
+
+	/* NOTE: [Improve] 다른 CPU에 넣었다면 그 CPU가 선점해야 하는지 확인 */
+	if (t->cpu != this_cpu()->id)
+		cpu_preempt_check(t->cpu, t->priority);
 	intr_set_level(old_level);
 }
 
@@ -352,18 +499,20 @@ void thread_exit(void)
 
 void thread_compare_yield(void)
 {
-	if (thread_current() == idle_thread)
-	{
-		return;
-	}
+	enum intr_level old_level = intr_disable();
+	struct run_queue *rq = this_rq();
+	bool yield = !is_idle_thread(thread_current()) && rq->bitmap != 0 &&
+				 thread_current()->priority < ready_queue_max_priority(rq);
+	intr_set_level(old_level);
 
-	if (list_empty(&ready_list))
+	if (yield)
 	{
-		return;
+		/* 인터럽트 핸들러 안에서는 바로 yield할 수 없으므로 복귀 시점에 양보 */
+		if (intr_context())
+			intr_yield_on_return();
+		else
+			thread_yield();
 	}
-
-	if (thread_current()->priority < list_entry(list_begin(&ready_list), struct thread, elem)->priority)
-		thread_yield();
 }
 
 /**
@@ -383,11 +532,16 @@ void thread_yield(void)
 	old_level = intr_disable();
 
 	/**
-	 * NOTE: ready_list에 우선순위 순으로 삽입
+	 * NOTE: [Improve] 우선순위에 해당하는 ready queue의 맨 뒤에 삽입 (O(1))
 	 * part: priority-insert-ordered
+	 * MLFQS에서는 4 tick마다의 재계산 이후 쓴 CPU 시간까지 반영한 우선순위로 넣는다.
 	 */
-	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, compare_priority, NULL);
+	if (!is_idle_thread(curr))
+	{
+		if (thread_mlfqs)
+			mlfqs_refresh(curr);
+		ready_queue_push(curr);
+	}
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
 }
@@ -406,49 +560,78 @@ void thread_sleep(int64_t wakeup_tick)
 
 	old_level = intr_disable(); /* 인터럽트 비활성화 */
 
-	if (curr != idle_thread)
+	if (!is_idle_thread(curr))
 	{
 		curr->wakeup_tick = wakeup_tick; /* local tick 설정 */
-		if (wakeup_tick < global_tick)	 /* 필요시 global_tick 갱신 */
-			set_global_tick(wakeup_tick);
-		list_push_back(&sleep_list, &curr->elem); /* sleep_list에 쓰레드 삽입 */
+		wheel_insert(curr);				 /* 타이밍 휠에 쓰레드 삽입 (O(1)) */
+		sleeping_cnt++;
+		if (thread_mlfqs) /* NOTE: [Improve] thread_block()과 같이 잠들 때 priority 갱신 */
+			mlfqs_refresh(curr);
 	}
 	do_schedule(THREAD_BLOCKED); /* 현재 쓰레드를 blocked 상태로 스케줄링 */
 	intr_set_level(old_level);	 /* 이전 인터럽트 복원 */
 }
 
 /**
- * @brief 주어진 틱 시간에 깨어날 쓰레드를 깨우는 함수
+ * @brief 주어진 틱 시간까지 깨어나야 할 쓰레드를 깨우는 함수
+ *
+ * 타이머 인터럽트에서 매 tick 호출된다. 아직 처리하지 않은 tick마다
+ * level 0의 해당 칸에 있는 쓰레드만 깨우므로, 잠든 쓰레드 수와 상관없이
+ * tick당 O(1) (+ 깨어나는 쓰레드 수) 비용이 든다.
  *
  * @param curr_tick 현재 시간을 나타내는 틱 값
  */
 void thread_wakeup(int64_t curr_tick)
 {
-	if (global_tick > curr_tick) /* 현재 tick이 global tick보다 작은 경우 함수 종료 */
-		return;
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	if (list_empty(&sleep_list)) /* sleep_list가 비어있는 경우 함수 종료 */
+	if (sleeping_cnt == 0) /* 잠든 쓰레드가 없으면 휠의 모든 칸이 비어있으므로 바로 건너뜀 */
+	{
+		if (wheel_tick <= curr_tick)
+			wheel_tick = curr_tick + 1;
 		return;
+	}
 
-	struct list_elem *e;
-	struct thread *t;
-
-	e = list_begin(&sleep_list);
-	while (e != list_end(&sleep_list)) /* sleep_list를 순회하며 깨어날 쓰레드 처리 */
+	while (wheel_tick <= curr_tick)
 	{
-		t = list_entry(e, struct thread, elem); /* 해당 elem와 매핑된 thread */
+		int index = wheel_tick & WHEEL_L0_MASK;
+		struct list *slot = &wheel_l0[index];
 
-		if (t->wakeup_tick <= curr_tick) /* wakeup 필요 */
+		/* level 0이 한 바퀴 돌았으면 상위 level의 다음 칸을 내려보냄 */
+		if (index == 0)
+			for (int level = 0; level < WHEEL_UPPER_LEVELS && wheel_cascade(level) == 0; level++)
+				continue;
+
+		wheel_tick++;
+		while (!list_empty(slot)) /* 이 칸에 있는 쓰레드는 모두 wakeup_tick이 지남 */
 		{
-			e = list_remove(e); /* sleep_list에서 제거 */
-			thread_unblock(t);	/* 쓰레드 block 해제 후 */
-			thread_compare_yield();
-			set_global_tick(get_min_tick()); /* global_tick 갱신 */
+			struct thread *t = list_entry(list_pop_front(slot), struct thread, elem);
+			sleeping_cnt--;
+			thread_unblock(t);
 		}
-		else
-			e = e->next;
 	}
-	set_global_tick(get_min_tick()); /* global_tick 갱신 */
+	thread_compare_yield(); /* 깨어난 쓰레드가 더 높은 우선순위라면 인터럽트 복귀 시 양보 */
+}
+
+/** NOTE: [Improve]
+ * @brief LIMIT 전까지 타이머가 처리해야 할 일이 있는 가장 이른 tick을 반환하는 함수
+ *
+ * level 0에서 비어있지 않은 칸이나 상위 level의 cascade 시점 중 먼저 오는 tick을
+ * 찾는다. 없으면 LIMIT을 반환한다. idle one-shot의 길이를 정할 때 쓴다.
+ */
+int64_t thread_next_wakeup(int64_t limit)
+{
+	int64_t tick;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (sleeping_cnt == 0)
+		return limit;
+
+	for (tick = wheel_tick; tick < limit; tick++)
+		if ((tick & WHEEL_L0_MASK) == 0 || !list_empty(&wheel_l0[tick & WHEEL_L0_MASK]))
+			return tick;
+	return limit;
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
@@ -465,18 +648,36 @@ void thread_set_priority(int new_priority)
 	thread_current()->origin_priority = new_priority;
 
 	/**
-	 * NOTE: Reorder the ready_list
+	 * NOTE: 우선순위가 낮아졌다면 더 높은 ready 쓰레드에게 양보
 	 * part: priority-insert-ordered
 	 */
-	// if(thread_current()->wait_on_lock != NULL){
-	// 	update_donate_priority(&thread_current()->wait_on_lock);
-	// }
 	update_donate_priority();
-	if (!list_empty(&ready_list))
+	thread_compare_yield();
+}
+
+/** NOTE: [Improve]
+ * @brief 쓰레드 T의 (유효) 우선순위를 PRIORITY로 변경하는 함수
+ *
+ * T가 ready 상태라면 기존 우선순위의 큐에서 빼서 새 우선순위 큐의 맨 뒤로 옮긴다.
+ * donation이나 MLFQS 재계산처럼 다른 쓰레드의 우선순위를 바꿀 때는
+ * t->priority에 직접 대입하지 말고 반드시 이 함수를 사용해야 한다.
+ */
+void thread_change_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (t->priority != priority)
 	{
-		struct thread *t = list_entry(list_front(&ready_list), struct thread, elem);
-		thread_compare_yield();
+		if (t->status == THREAD_READY)
+		{
+			ready_queue_remove(t);
+			t->priority = priority;
+			ready_queue_push(t);
+		}
+		else
+			t->priority = priority;
 	}
+	intr_set_level(old_level);
 }
 
 /* Returns the current thread's priority. */
@@ -491,13 +692,29 @@ int thread_get_priority(void)
 void thread_set_nice(int new_nice)
 {
 	enum intr_level old_level = intr_disable();
-	if (thread_current() != idle_thread)
+	if (!is_idle_thread(thread_current()))
 		thread_current()->nice = new_nice;
 	thread_calc_priority(thread_current());
 	thread_compare_yield();
 	intr_set_level(old_level);
 }
 
+/** NOTE: [Improve]
+ * @brief 현재 쓰레드를 background 쓰레드로 표시하는 함수
+ *
+ * background 쓰레드는 다른 쓰레드가 쓰지 않는 CPU 시간에만 도는 쓰레드로,
+ * ready 상태이거나 실행 중이어도 load_avg에 세지 않는다. MLFQS에서도
+ * 우선순위를 다시 계산하지 않고 PRI_MIN에 고정한다 (mlfqs_priority() 참고).
+ */
+void thread_set_background(void)
+{
+	enum intr_level old_level = intr_disable();
+	thread_current()->background = true;
+	if (thread_mlfqs)
+		thread_current()->priority = PRI_MIN;
+	intr_set_level(old_level);
+}
+
 /** NOTE: [Part3]
  * @brief 현재 실행 중인 쓰레드의 nice 값을 반환하는 함수
  *
@@ -520,7 +737,7 @@ int thread_get_nice(void)
 int thread_get_load_avg(void)
 {
 	enum intr_level old_level = intr_disable();
-	fixed_point load_avg_100_times = mul_fp(load_avg, int_to_fp(100)); /* 100배 */
+	fixed_point load_avg_100_times = mul_fp_int(load_avg, 100);	   /* 100배 */
 	int load_avg = fp_to_int_round_zero(load_avg_100_times);		   /* 정수로 변환 */
 	intr_set_level(old_level);
 
@@ -536,7 +753,7 @@ int thread_get_load_avg(void)
 int thread_get_recent_cpu(void)
 {
 	enum intr_level old_level = intr_disable();
-	fixed_point recent_cpu_100_times = mul_fp(thread_current()->recent_cpu, int_to_fp(100)); /* 100배 */
+	fixed_point recent_cpu_100_times = mul_fp_int(thread_current()->recent_cpu, 100);	   /* 100배 */
 	int recent_cpu = fp_to_int_round_zero(recent_cpu_100_times);							 /* 정수로 변환 */
 	intr_set_level(old_level);
 
@@ -547,7 +764,7 @@ int thread_get_recent_cpu(void)
 
    The idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
+   point it initializes this CPU's idle_thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
@@ -557,15 +774,30 @@ idle(void *idle_started_ UNUSED)
 {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current();
+	this_cpu()->idle_thread = thread_current();
 	sema_up(idle_started);
 
+	thread_run_idle();
+}
+
+/** NOTE: [Improve]
+ * @brief 모든 CPU의 idle 쓰레드가 공유하는 idle 루프
+ *
+ * hlt로 잠들기 전에 big kernel lock을 놓아서 다른 CPU가 커널에 들어올 수
+ * 있게 한다. 인터럽트로 깨어나면 intr_handler()가 다시 lock을 잡는다.
+ */
+void thread_run_idle(void)
+{
 	for (;;)
 	{
 		/* Let someone else run. */
 		intr_disable();
 		thread_block();
 
+		/* NOTE: [Improve] 다음에 할 일이 생길 때까지 (최대 몇 tick) 타이머 인터럽트를 미룸 */
+		timer_idle_enter();
+		kernel_lock_release();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -616,6 +848,12 @@ init_thread(struct thread *t, const char *name, int priority)
 	/* NOTE: [Part3] MLFQ를 위한 데이터 초기화 */
 	t->nice = 0;
 	t->recent_cpu = 0;
+	t->recent_cpu_epoch = decay_epoch;
+
+	/* NOTE: [Improve] 처음에는 만든 CPU에서 실행 (thread_unblock()에서 다시 고름) */
+	t->cpu = this_cpu()->id;
+	t->fpu_cpu = -1;
+	t->background = false;
 
 	/* NOTE: [Improve] 모든 쓰레드 생성 시 all_list에 추가 */
 	list_push_back(&all_list, &t->all_elem);
@@ -629,19 +867,256 @@ init_thread(struct thread *t, const char *name, int priority)
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   this CPU's idle_thread. */
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
-		return idle_thread;
+	struct run_queue *rq = this_rq();
+	struct thread *t = NULL;
+
+	spin_lock(&rq->lock);
+	if (rq->bitmap != 0)
+	{
+		/* NOTE: [Improve] 가장 높은 우선순위 큐의 맨 앞 쓰레드 (같은 우선순위 내에서는 FIFO) */
+		t = list_entry(list_front(&rq->queues[ready_queue_max_priority(rq)]),
+					   struct thread, elem);
+		run_queue_unlink(rq, t);
+	}
+	spin_unlock(&rq->lock);
+
+	/* NOTE: [Improve] 내 run queue가 비었으면 다른 CPU에서 훔쳐옴 */
+	if (t == NULL)
+		t = steal_thread();
+	return t != NULL ? t : this_cpu()->idle_thread;
+}
+
+/** NOTE: [Improve]
+ * @brief T를 자신의 우선순위에 해당하는 ready queue의 맨 뒤에 넣고 비트맵을 갱신하는 함수
+ */
+static void ready_queue_push(struct thread *t)
+{
+	struct run_queue *rq = &run_queues[t->cpu];
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	spin_lock(&rq->lock);
+	list_push_back(&rq->queues[t->priority], &t->elem);
+	rq->bitmap |= (uint64_t)1 << t->priority;
+	rq->cnt++;
+	ready_threads_cnt++;
+	if (t->background)
+		ready_background_cnt++;
+	spin_unlock(&rq->lock);
+}
+
+/** NOTE: [Improve]
+ * @brief ready queue에서 T를 빼고, 큐가 비었다면 비트맵의 해당 비트를 지우는 함수
+ */
+static void ready_queue_remove(struct thread *t)
+{
+	struct run_queue *rq = &run_queues[t->cpu];
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	spin_lock(&rq->lock);
+	run_queue_unlink(rq, t);
+	spin_unlock(&rq->lock);
+}
+
+/** NOTE: [Improve]
+ * @brief RQ의 lock을 잡은 상태에서 T를 빼고 비트맵과 쓰레드 수를 갱신하는 함수
+ */
+static void run_queue_unlink(struct run_queue *rq, struct thread *t)
+{
+	ASSERT(spin_lock_held(&rq->lock));
+
+	list_remove(&t->elem);
+	if (list_empty(&rq->queues[t->priority]))
+		rq->bitmap &= ~((uint64_t)1 << t->priority);
+	rq->cnt--;
+	ready_threads_cnt--;
+	if (t->background)
+		ready_background_cnt--;
+}
+
+/** NOTE: [Improve]
+ * @brief 다른 CPU로 옮길 쓰레드를 RQ에서 골라 빼는 함수 (없으면 NULL)
+ *
+ * 높은 우선순위 큐부터 보면서 캐시가 식은 쓰레드를 고른다. 모두 캐시가
+ * 따뜻하다면 ALLOW_HOT일 때만 가장 높은 우선순위 큐의 맨 뒤, 즉 그 CPU에서
+ * 가장 늦게 실행될 쓰레드를 고른다.
+ */
+static struct thread *run_queue_detach(struct run_queue *rq, bool allow_hot)
+{
+	struct thread *victim = NULL;
+	int64_t now = timer_ticks();
+
+	spin_lock(&rq->lock);
+	for (int pri = PRI_MAX; pri >= PRI_MIN && victim == NULL; pri--)
+	{
+		struct list_elem *e;
+
+		if ((rq->bitmap & ((uint64_t)1 << pri)) == 0)
+			continue;
+		for (e = list_begin(&rq->queues[pri]); e != list_end(&rq->queues[pri]); e = list_next(e))
+		{
+			struct thread *t = list_entry(e, struct thread, elem);
+			if (now - t->last_run >= CACHE_HOT_TICKS)
+			{
+				victim = t;
+				break;
+			}
+		}
+	}
+	if (victim == NULL && allow_hot && rq->bitmap != 0)
+		victim = list_entry(list_back(&rq->queues[ready_queue_max_priority(rq)]),
+							struct thread, elem);
+	if (victim != NULL)
+		run_queue_unlink(rq, victim);
+	spin_unlock(&rq->lock);
+	return victim;
+}
+
+/** NOTE: [Improve]
+ * @brief 현재 CPU가 실행할 쓰레드를 가장 바쁜 CPU의 run queue에서 훔쳐오는 함수
+ *
+ * 상대 CPU에 두 개 이상 기다리고 있다면 캐시를 잃는 것보다 기다리는 것이
+ * 더 손해이므로 캐시가 따뜻한 쓰레드도 가져온다.
+ */
+static struct thread *steal_thread(void)
+{
+	int self = this_cpu()->id;
+	int busiest = -1;
+
+	if (cpu_cnt == 1)
+		return NULL;
+
+	for (int i = 0; i < CPU_MAX; i++)
+		if (i != self && cpus[i].online && run_queues[i].cnt > 0 &&
+			(busiest < 0 || run_queues[i].cnt > run_queues[busiest].cnt))
+			busiest = i;
+	if (busiest < 0)
+		return NULL;
+	return run_queue_detach(&run_queues[busiest], run_queues[busiest].cnt >= 2);
+}
+
+/** NOTE: [Improve]
+ * @brief BALANCE_INTERVAL tick마다 CPU별 평균 부하를 갱신하고 쓰레드 하나를 옮기는 함수
+ *
+ * 평균 부하가 가장 큰 CPU와 가장 작은 CPU의 차이가 1 이상이고, 지금도 실제로
+ * 2 이상 차이가 날 때만 캐시가 식은 쓰레드를 하나 옮긴다. 타이머 인터럽트에서 호출된다.
+ */
+void thread_balance(void)
+{
+	int busiest = -1, idlest = -1;
+	struct thread *t;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (int i = 0; i < CPU_MAX; i++)
+	{
+		if (!cpus[i].online)
+			continue;
+		cpu_load_avg[i] = add_fp(mul_fp(CPU_LOAD_WEIGHT_OLD, cpu_load_avg[i]),
+								 mul_fp_int(CPU_LOAD_WEIGHT_NEW, cpu_load(i)));
+		if (busiest < 0 || cpu_load_avg[i] > cpu_load_avg[busiest])
+			busiest = i;
+		if (idlest < 0 || cpu_load_avg[i] < cpu_load_avg[idlest])
+			idlest = i;
+	}
+
+	if (busiest == idlest || run_queues[busiest].cnt == 0)
+		return;
+	if (sub_fp(cpu_load_avg[busiest], cpu_load_avg[idlest]) < FP_CONST(1) ||
+		cpu_load(busiest) < cpu_load(idlest) + 2)
+		return;
+
+	t = run_queue_detach(&run_queues[busiest], false);
+	if (t == NULL)
+		return;
+	t->cpu = idlest;
+	ready_queue_push(t);
+	if (idlest == this_cpu()->id)
+		thread_compare_yield();
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+		cpu_preempt_check(idlest, t->priority);
+}
+
+/** NOTE: [Improve]
+ * @brief 비어있지 않은 ready queue 중 가장 높은 우선순위를 반환하는 함수 (없으면 -1)
+ *
+ * bsr 명령어로 RQ의 bitmap에서 가장 높은 1 비트의 위치를 한 번에 찾는다.
+ */
+static int ready_queue_max_priority(struct run_queue *rq)
+{
+	uint64_t pri;
+	uint64_t bitmap = rq->bitmap;
+
+	if (bitmap == 0)
+		return -1;
+	__asm __volatile("bsrq %1, %0" : "=r"(pri) : "rm"(bitmap));
+	return (int)pri;
+}
+
+/** NOTE: [Improve]
+ * @brief CPU의 부하(ready 쓰레드 수 + idle이 아닌 실행 중 쓰레드)를 반환하는 함수
+ */
+static size_t cpu_load(int cpu)
+{
+	struct cpu *c = &cpus[cpu];
+
+	return run_queues[cpu].cnt + (c->curr != NULL && c->curr != c->idle_thread);
+}
+
+/** NOTE: [Improve]
+ * @brief 깨어나는 쓰레드 T가 실행될 CPU를 고르는 함수
+ *
+ * 캐시 친화성을 위해 마지막으로 실행된 CPU가 한가하면 그대로 쓰고,
+ * 그렇지 않으면 온라인 CPU 중 부하가 가장 작은 CPU를 고른다.
+ */
+static int select_cpu(struct thread *t)
+{
+	int best = t->cpu;
+
+	if (cpu_cnt == 1)
+		return this_cpu()->id;
+
+	if (best < 0 || best >= CPU_MAX || !cpus[best].online)
+		best = this_cpu()->id;
+	if (cpu_load(best) == 0)
+		return best;
+
+	for (int i = 0; i < CPU_MAX; i++)
+		if (cpus[i].online && cpu_load(i) < cpu_load(best))
+			best = i;
+	return best;
+}
+
+/** NOTE: [Improve]
+ * @brief 다른 CPU에 PRIORITY 쓰레드를 넣은 뒤, 그 CPU가 선점해야 하면 IPI를 보내는 함수
+ */
+static void cpu_preempt_check(int cpu, int priority)
+{
+	struct cpu *c = &cpus[cpu];
+	struct thread *curr = c->curr;
+
+	if (!c->online)
+		return;
+	if (curr == NULL || curr == c->idle_thread || curr->priority < priority)
+		cpu_send_ipi(c, IPI_RESCHEDULE);
 }
 
 /* Use iretq to launch the thread */
 void do_iret(struct intr_frame *tf)
 {
+	/* NOTE: [Improve] 유저 모드로 돌아가기 전에 big kernel lock을 놓음 */
+	if ((tf->cs & 3) == 3)
+	{
+		intr_disable();
+		kernel_lock_release();
+	}
+
 	__asm __volatile(
 		"movq %0, %%rsp\n"
 		"movq 0(%%rsp),%%r15\n"
@@ -663,6 +1138,10 @@ void do_iret(struct intr_frame *tf)
 		"movw 8(%%rsp),%%ds\n"
 		"movw (%%rsp),%%es\n"
 		"addq $32, %%rsp\n"
+		"testb $3, 8(%%rsp)\n" /* NOTE: [Improve] 유저 모드로 돌아갈 때는 GS base를 유저 것으로 */
+		"jz 1f\n"
+		"swapgs\n"
+		"1:\n"
 		"iretq"
 		: : "g"((uint64_t)tf) : "memory");
 }
@@ -684,6 +1163,19 @@ thread_launch(struct thread *th)
 	uint64_t tf = (uint64_t)&th->tf;
 	ASSERT(intr_get_level() == INTR_OFF);
 
+	/* NOTE: [Improve] 커널에서 커널로의 문맥 교환은 callee-saved 레지스터와
+	   rsp/rip만 저장하면 된다. 처음 실행되는 쓰레드(ksp == 0)는 switch_threads()가
+	   th->tf로 do_iret()을 부른다. 빠른 경로로 저장된 쓰레드는 반드시 빠른
+	   경로로 재개해야 하므로 thread_iret_switch와 상관없이 여기로 온다. */
+	if (!thread_iret_switch || th->ksp != 0)
+	{
+		switch_threads(&running_thread()->ksp, th->ksp, &th->tf);
+		return;
+	}
+
+	/* tf에 저장하므로 다시 실행될 때는 do_iret()으로 재개 */
+	running_thread()->ksp = 0;
+
 	/* The main switching logic.
 	 * We first restore the whole execution context into the intr_frame
 	 * and then switching to the next thread by calling do_iret.
@@ -760,16 +1252,25 @@ static void
 schedule(void)
 {
 	struct thread *curr = running_thread();
-	struct thread *next = next_thread_to_run();
+	struct cpu *c = this_cpu();
+	struct thread *next;
+
+	/* NOTE: [Improve] idle을 벗어나면 idle one-shot을 취소하고 주기 모드로 복귀 */
+	if (curr == c->idle_thread && run_queues[c->id].bitmap != 0)
+		timer_idle_exit();
+
+	next = next_thread_to_run();
 
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(curr->status != THREAD_RUNNING);
 	ASSERT(is_thread(next));
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->cpu = c->id;
+	c->curr = next;
 
 	/* Start new time slice. */
-	thread_ticks = 0;
+	c->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -778,6 +1279,12 @@ schedule(void)
 
 	if (curr != next)
 	{
+		/* NOTE: [Improve] 캐시가 따뜻한지 판단하기 위해 마지막으로 실행된 시각을 기록 */
+		curr->last_run = timer_ticks();
+
+		/* NOTE: [Improve] 이번 time slice에 FPU를 썼을 때만 저장하고 TS를 켬 */
+		fpu_switch(curr);
+
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
@@ -811,38 +1318,58 @@ allocate_tid(void)
 	return tid;
 }
 
-static int64_t get_min_tick(void)
+/** NOTE: [Improve]
+ * @brief 잠든 쓰레드 T를 wakeup_tick에 맞는 타이밍 휠 칸에 넣는 함수
+ *
+ * wheel_tick으로부터 남은 tick 수에 따라 level을 고르고, 그 level 안에서는
+ * wakeup_tick의 해당 비트들로 칸을 고른다. 범위를 넘으면 가장 먼 칸에 넣어두고
+ * cascade될 때 다시 자리를 찾는다.
+ */
+static void wheel_insert(struct thread *t)
 {
-	if (list_empty(&sleep_list))
-		return INT64_MAX;
-	return list_entry(list_min(&sleep_list, wakeup_less, NULL), struct thread, elem)->wakeup_tick;
-}
+	int64_t expires = t->wakeup_tick;
+	int64_t idx = expires - wheel_tick;
+	struct list *slot;
 
-static int set_global_tick(int64_t tick)
-{
-	if (global_tick <= tick) /* 입력받은 tick이 global_tick보다 크면 예외처리 */
-		return 0;
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	/* global_tick 갱신 */
-	global_tick = tick;
-	return 1;
+	if (idx < 0) /* 이미 지난 시간: 바로 다음에 처리할 칸에 넣음 */
+		slot = &wheel_l0[wheel_tick & WHEEL_L0_MASK];
+	else if (idx < WHEEL_L0_SIZE)
+		slot = &wheel_l0[expires & WHEEL_L0_MASK];
+	else
+	{
+		int level;
+
+		if (idx > WHEEL_MAX_TICKS)
+			expires = wheel_tick + WHEEL_MAX_TICKS;
+		for (level = 0; level < WHEEL_UPPER_LEVELS - 1; level++)
+			if (idx < ((int64_t)1 << WHEEL_LN_SHIFT(level + 1)))
+				break;
+		slot = &wheel_ln[level][(expires >> WHEEL_LN_SHIFT(level)) & WHEEL_LN_MASK];
+	}
+	list_push_back(slot, &t->elem);
 }
 
-/**
- * @brief 두 쓰레드의 깨어날 시간을 비교하는 함수
+/** NOTE: [Improve]
+ * @brief 상위 LEVEL의 현재 칸에 있는 쓰레드들을 한 단계 아래 칸으로 다시 나누는 함수
  *
- * @param a_ 첫 번째 쓰레드의 리스트 요소
- * @param b_ 두 번째 쓰레드의 리스트 요소
- * @param UNUSED 사용되지 않는 매개변수
- * @return true 첫 번째 쓰레드의 깨어날 시간이 두 번째 쓰레드의 깨어날 시간보다 이전인 경우
- * @return false 그렇지 않은 경우
+ * @return int cascade한 칸의 인덱스. 0이면 그 level도 한 바퀴 돈 것이므로
+ *             호출자는 다음 level도 cascade해야 한다.
  */
-static bool wakeup_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
+static int wheel_cascade(int level)
 {
-	const struct thread *a = list_entry(a_, struct thread, elem);
-	const struct thread *b = list_entry(b_, struct thread, elem);
+	int index = (wheel_tick >> WHEEL_LN_SHIFT(level)) & WHEEL_LN_MASK;
+	struct list *slot = &wheel_ln[level][index];
+	struct list moving;
+
+	list_init(&moving);
+	while (!list_empty(slot))
+		list_push_back(&moving, list_pop_front(slot));
+	while (!list_empty(&moving))
+		wheel_insert(list_entry(list_pop_front(&moving), struct thread, elem));
 
-	return a->wakeup_tick < b->wakeup_tick;
+	return index;
 }
 
 /* NOTE: priority-insert-ordered
@@ -864,88 +1391,185 @@ bool compare_priority(struct list_elem *a, struct list_elem *b, void *aux UNUSED
 }
 
 /* NOTE: [Part3] recent_cpu와 nice를 이용해 priority를 계산하는 함수 구현 */
-void thread_calc_priority(struct thread *t)
+static int mlfqs_priority(struct thread *t)
 {
-	fixed_point quarter_cpu = div_fp(t->recent_cpu, int_to_fp(4));
+	/* NOTE: [Improve] background 쓰레드는 recent_cpu가 작아도 다른 쓰레드를 앞서지 않음 */
+	if (t->background)
+		return PRI_MIN;
+
+	fixed_point quarter_cpu = div_fp_int(t->recent_cpu, 4);
 	int cpu_to_priority = fp_to_int_round_zero(quarter_cpu);
 	int nice_to_priority = t->nice * 2;
+	int priority = PRI_MAX - cpu_to_priority - nice_to_priority;
+
+	/* NOTE: [Improve] 우선순위가 ready queue 인덱스로 쓰이므로 PRI_MIN..PRI_MAX로 제한 */
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	return priority;
+}
 
-	t->priority = PRI_MAX - cpu_to_priority - nice_to_priority;
+/* NOTE: [Improve] ready queue에 없는 T의 밀린 recent_cpu decay와 priority를 바로 반영 */
+static void mlfqs_refresh(struct thread *t)
+{
+	thread_calc_recent_cpu(t);
+	t->priority = mlfqs_priority(t);
 }
 
-/* NOTE: [Part3] recent_cpu를 계산하는 함수 구현 */
-void thread_calc_recent_cpu(struct thread *t)
+/* NOTE: [Part3] T의 priority를 재계산하고, ready 상태라면 ready queue도 옮기는 함수 */
+void thread_calc_priority(struct thread *t)
 {
-	/* 계산에 필요한 정수를 고정 소수점 값으로 변경 */
-	fixed_point one = int_to_fp(1);
-	fixed_point two = int_to_fp(2);
+	thread_change_priority(t, mlfqs_priority(t));
+}
 
-	/* decay 계산 */
-	fixed_point double_load_avg = mul_fp(two, load_avg);
-	fixed_point double_load_avg_plus_one = add_fp(double_load_avg, one);
-	fixed_point decay = div_fp(double_load_avg, double_load_avg_plus_one);
+/** NOTE: [Part3/Improve]
+ * @brief T의 recent_cpu에 아직 반영되지 않은 초당 decay를 한꺼번에 적용하는 함수
+ *
+ * 1초마다 recent_cpu = d * recent_cpu + nice 를 적용해야 하지만, 잠든 쓰레드는
+ * 매초 건드리지 않고 깨어나거나 다시 살펴볼 때 밀린 decay를 decay_maps로 한 번에
+ * 반영한다. 그 초들의 decay 계수를 차례로 적용한 것과 같다 (고정 소수점 반올림 차이뿐).
+ */
+void thread_calc_recent_cpu(struct thread *t)
+{
+	int64_t missed = decay_epoch - t->recent_cpu_epoch;
+	const struct decay_map *map;
 
-	/* 감쇄된 recent_cpu 및 고정 소수점 값으로 변환한 nice */
-	fixed_point decayed_recent_cpu = mul_fp(decay, t->recent_cpu);
-	fixed_point nice_fp = int_to_fp(t->nice);
+	ASSERT(0 <= missed && missed < DECAY_HISTORY);
+	if (missed == 0)
+		return;
 
-	t->recent_cpu = add_fp(decayed_recent_cpu, nice_fp);
+	map = &decay_maps[t->recent_cpu_epoch % DECAY_HISTORY];
+	t->recent_cpu = add_fp(mul_fp(map->mul, t->recent_cpu), mul_fp_int(map->add, t->nice));
+	t->recent_cpu_epoch = decay_epoch;
 }
 
 /* NOTE: [Part3] load_avg를 계산하는 함수 구현 */
-void calc_load_avg()
+void mlfqs_calculate_load_avg(void)
 {
-	/* 계산에 필요한 가중치 계산 */
-	fixed_point weight_59 = div_fp(int_to_fp(59), int_to_fp(60));
-	fixed_point weight_1 = div_fp(int_to_fp(1), int_to_fp(60));
-
-	/* read_thread 계산: ready_list에 담긴 쓰레드의 개수 + 실행 중인 쓰레드의 개수 (idle 제외) */
-	fixed_point count_ready_threads = int_to_fp(list_size(&ready_list));
-	if (thread_current() != idle_thread)
-		count_ready_threads = add_fp(count_ready_threads, int_to_fp(1));
-
-	/* 가중치 적용 */
-	fixed_point weighted_avg = mul_fp(weight_59, load_avg);
-	fixed_point weighted_ready_threads = mul_fp(weight_1, count_ready_threads);
+	/* read_thread 계산: ready queue에 담긴 쓰레드의 개수 + 실행 중인 쓰레드의 개수 (idle 제외) */
+	/* NOTE: [Improve] 남는 CPU 시간만 쓰는 background 쓰레드(palloc.c의 zeroer)도 제외 */
+	int ready_threads = ready_threads_cnt - ready_background_cnt;
+	for (int i = 0; i < CPU_MAX; i++) /* NOTE: [Improve] 모든 CPU에서 실행 중인 쓰레드 */
+		if (cpus[i].online && cpus[i].curr != NULL && cpus[i].curr != cpus[i].idle_thread &&
+			!cpus[i].curr->background)
+			ready_threads++;
+
+	/* 가중치 적용 (가중치는 컴파일 시간 상수) */
+	fixed_point weighted_avg = mul_fp(LOAD_AVG_WEIGHT_59, load_avg);
+	fixed_point weighted_ready_threads = mul_fp_int(LOAD_AVG_WEIGHT_1, ready_threads);
 
 	load_avg = add_fp(weighted_avg, weighted_ready_threads);
 }
 
-/* NOTE: [Part3] recent_cpu를 1씩 증가시키는 함수 구현 */
-void thread_incr_recent_cpu()
+/* NOTE: [Part3] 실행 중인 쓰레드의 recent_cpu를 1씩 증가시키는 함수 구현 */
+void mlfqs_increase_recent_cpu(void)
 {
 	struct thread *curr = thread_current();
 
-	if (curr != idle_thread)
-		curr->recent_cpu = add_fp(curr->recent_cpu, int_to_fp(1));
+	if (!is_idle_thread(curr))
+		curr->recent_cpu = add_fp_int(curr->recent_cpu, 1);
 }
 
-/* NOTE: [Part3/Improve] `모든` 쓰레드의 우선순위를 재계산하는 함수 구현 */
-void thread_all_calc_priority()
+/** NOTE: [Part3/Improve]
+ * @brief 4 tick마다 `실행 중인` 쓰레드의 우선순위만 재계산하는 함수
+ *
+ * 1초 사이에 recent_cpu가 바뀌는 쓰레드는 실행 중인 쓰레드뿐이다. ready queue와
+ * 잠든 쓰레드의 우선순위는 그대로이므로 건드리지 않고, 다시 살펴볼 때
+ * (깨어날 때, 또는 1초마다 decay epoch가 바뀔 때) 재계산한다. 비용은 O(CPU 수)이다.
+ */
+void mlfqs_recalculate_priority(void)
 {
-	struct list_elem *e;
-	struct thread *t;
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	e = list_begin(&all_list);
-	while (e != list_end(&all_list))
+	for (int c = 0; c < CPU_MAX; c++)
 	{
-		t = list_entry(e, struct thread, all_elem);
-		thread_calc_priority(t);
-		e = list_next(e);
+		struct run_queue *rq = &run_queues[c];
+		struct thread *curr = cpus[c].curr;
+
+		if (!cpus[c].online || curr == NULL)
+			continue;
+
+		if (!is_idle_thread(curr))
+			thread_calc_priority(curr);
+		if (c != this_cpu()->id && rq->bitmap != 0 &&
+			(is_idle_thread(curr) || curr->priority < ready_queue_max_priority(rq)))
+			cpu_send_ipi(&cpus[c], IPI_RESCHEDULE);
 	}
+	thread_compare_yield();
 }
 
-/* NOTE: [Part3/Improve] `모든` 쓰레드의 recent_cpu를 재계산하는 함수 구현 */
-void thread_all_calc_recent_cpu()
+/** NOTE: [Part3/Improve]
+ * @brief 1초마다 decay epoch를 넘기고 `실행 가능한` 쓰레드의 recent_cpu와 우선순위를 갱신하는 함수
+ *
+ * decay가 바뀌면 ready queue에 있는 쓰레드의 우선순위도 바뀌므로, 이때만 ready queue를
+ * 통째로 비우고 새 우선순위 큐에 다시 넣는다. 비용은 O(ready 쓰레드 수)이다.
+ * 잠든 쓰레드는 깨어날 때 thread_calc_recent_cpu()로 밀린 epoch를 한꺼번에 반영하고,
+ * DECAY_HISTORY / 2초에 한 번만 모든 쓰레드를 훑는다.
+ */
+void mlfqs_recalculate_recent_cpu(void)
 {
-	struct list_elem *e;
-	struct thread *t;
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	/* decay 계산: (2 * load_avg) / (2 * load_avg + 1) */
+	fixed_point double_load_avg = mul_fp_int(load_avg, 2);
+	fixed_point decay = div_fp(double_load_avg, add_fp_int(double_load_avg, 1));
 
-	e = list_begin(&all_list);
-	while (e != list_end(&all_list))
+	for (int i = 0; i < DECAY_HISTORY; i++)
 	{
-		t = list_entry(e, struct thread, all_elem);
-		thread_calc_recent_cpu(t);
-		e = list_next(e);
+		struct decay_map *map = &decay_maps[i];
+		map->mul = mul_fp(decay, map->mul);
+		map->add = add_fp_int(mul_fp(decay, map->add), 1);
 	}
+	decay_epoch++;
+
+	/* 곧 재사용될 칸을 쓰는 쓰레드가 없도록 가끔 잠든 쓰레드까지 모두 따라잡게 함 */
+	if (decay_epoch % (DECAY_HISTORY / 2) == 0)
+		for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+		{
+			struct thread *t = list_entry(e, struct thread, all_elem);
+			if (!is_idle_thread(t))
+				thread_calc_recent_cpu(t);
+		}
+	decay_maps[decay_epoch % DECAY_HISTORY] = (struct decay_map){F, 0};
+
+	for (int c = 0; c < CPU_MAX; c++) /* NOTE: [Improve] 모든 CPU의 run queue + 실행 중인 쓰레드 */
+	{
+		struct run_queue *rq = &run_queues[c];
+		struct thread *curr = cpus[c].curr;
+		struct list runnable;
+
+		if (!cpus[c].online)
+			continue;
+
+		/* 높은 우선순위 큐부터 꺼내서 기존 실행 순서를 최대한 유지 */
+		list_init(&runnable);
+		spin_lock(&rq->lock);
+		while (rq->bitmap != 0)
+		{
+			int pri = ready_queue_max_priority(rq);
+			struct thread *t = list_entry(list_front(&rq->queues[pri]), struct thread, elem);
+			run_queue_unlink(rq, t);
+			list_push_back(&runnable, &t->elem);
+		}
+		spin_unlock(&rq->lock);
+
+		while (!list_empty(&runnable))
+		{
+			struct thread *t = list_entry(list_pop_front(&runnable), struct thread, elem);
+			if (!is_idle_thread(t))
+				mlfqs_refresh(t);
+			ready_queue_push(t);
+		}
+
+		if (curr != NULL && !is_idle_thread(curr))
+		{
+			thread_calc_recent_cpu(curr);
+			thread_calc_priority(curr);
+		}
+		if (c != this_cpu()->id && curr != NULL && rq->bitmap != 0 &&
+			(is_idle_thread(curr) || curr->priority < ready_queue_max_priority(rq)))
+			cpu_send_ipi(&cpus[c], IPI_RESCHEDULE);
+	}
+	thread_compare_yield();
 }
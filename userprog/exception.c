@@ -46,8 +46,8 @@ void exception_init(void)
 	intr_register_int(0, 0, INTR_ON, kill, "#DE Divide Error");
 	intr_register_int(1, 0, INTR_ON, kill, "#DB Debug Exception");
 	intr_register_int(6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-	intr_register_int(7, 0, INTR_ON, kill,
-					  "#NM Device Not Available Exception");
+	/* NOTE: [Improve] #NM (vector 7) is used for lazy FPU switching
+	   and is registered by fpu_init (). */
 	intr_register_int(11, 0, INTR_ON, kill, "#NP Segment Not Present");
 	intr_register_int(12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
 	intr_register_int(13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -11,6 +11,7 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
@@ -176,6 +177,10 @@ __do_fork(void *aux)
 	/* 1. Read the cpu context to local stack. */
 	memcpy(&if_, parent_if, sizeof(struct intr_frame));
 
+	/* NOTE: [Improve] 부모의 FPU 상태도 물려받음 (부모는 fork_sema에서 잠들어 있어 이미 저장됨) */
+	if (!fpu_copy(current, parent))
+		goto error;
+
 	/* 2. Duplicate PT */
 	current->pml4 = pml4_create();
 	if (current->pml4 == NULL)
@@ -409,6 +414,9 @@ process_cleanup(void)
 {
 	struct thread *curr = thread_current();
 
+	/* NOTE: [Improve] exec/exit: 이전 프로그램의 FPU 상태를 버림 */
+	fpu_release();
+
 #ifdef VM
 	supplemental_page_table_kill(&curr->spt);
 #endif
@@ -864,10 +872,10 @@ bool lazy_load_segment(struct page *page, void *aux)
 	file_seek(lazy_load_arg->file, lazy_load_arg->ofs);
 
 	/* 페이지에 매핑된 물리 메모리의 프레임에 이동시킨 ofs에서부터 파일의 데이터를 읽어옴 */
-	/* 제대로 읽어오지 못 했다면 -> 해당 페이지를 Free 시키고 False 반환 */
+	/* 제대로 읽어오지 못 했다면 -> False 반환 */
+	/* NOTE: [Improve] 프레임은 frame table 소유이므로 여기서 해제하지 않고, 페이지를 지울 때 함께 해제됨 */
 	if (file_read(lazy_load_arg->file, page->frame->kva, lazy_load_arg->read_bytes) != (int)(lazy_load_arg->read_bytes))
 	{
-		palloc_free_page(page->frame->kva);
 		return false;
 	}
 	/* 남는 부분은 0으로 초기화 */
@@ -898,33 +906,14 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT(pg_ofs(upage) == 0);
 	ASSERT(ofs % PGSIZE == 0);
 
-	while (read_bytes > 0 || zero_bytes > 0)
-	{
-		/* Do calculate how to fill this page.
-		 * We will read PAGE_READ_BYTES bytes from FILE
-		 * and zero the final PAGE_ZERO_BYTES bytes. */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		/* lazy_load_segment에 인자로 전달해 줄 보조 인자를 담아주기 */
-		struct lazy_load_arg *lazy_load_arg = (struct lazy_load_arg *)malloc(sizeof(struct lazy_load_arg));
-		lazy_load_arg->file = file;
-		lazy_load_arg->ofs = ofs;
-		lazy_load_arg->read_bytes = page_read_bytes;
-		lazy_load_arg->zero_bytes = page_zero_bytes;
-
-		if (!vm_alloc_page_with_initializer(VM_ANON, upage,
-											writable, lazy_load_segment, lazy_load_arg))
-			return false;
+	if (read_bytes + zero_bytes == 0)
+		return true;
 
-		/* Advance. */
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		upage += PGSIZE;
-		ofs += page_read_bytes;
-	}
-	return true;
+	/* NOTE: [Improve] 세그먼트 전체를 범위 하나(VMA)로 등록하고, 페이지는 폴트 때 만든다.
+	   읽기 전용 세그먼트(text)는 file-backed 페이지로 만들어서 같은 실행 파일을 띄운
+	   프로세스끼리 프레임을 공유하고, 퇴거 후에는 파일에서 다시 읽도록 */
+	return vma_map(&thread_current()->spt, upage, read_bytes + zero_bytes, file, ofs,
+				   read_bytes, writable ? VM_ANON : VM_FILE, writable, false);
 }
 
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
@@ -19,6 +19,7 @@
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
+static void *get_phys_addr(void *addr);
 
 /* System call.
  *
@@ -34,6 +35,13 @@ void syscall_handler(struct intr_frame *);
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
 
 void syscall_init(void)
+{
+	syscall_init_cpu();
+	lock_init(&filesys_lock);
+}
+
+/* NOTE: [Improve] syscall 관련 MSR은 CPU마다 따로 있으므로 AP도 부팅 시 호출 */
+void syscall_init_cpu(void)
 {
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48 |
 							((uint64_t)SEL_KCSEG) << 32);
@@ -44,7 +52,6 @@ void syscall_init(void)
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			  FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-	lock_init(&filesys_lock);
 }
 
 /* The main system call interface */
@@ -111,6 +118,9 @@ void syscall_handler(struct intr_frame *f UNUSED)
 	case SYS_MUNMAP:
 		do_munmap(f->R.rdi);
 		break;
+	case SYS_GET_PHYS_ADDR:
+		f->R.rax = (uint64_t) get_phys_addr((void *) f->R.rdi);
+		break;
 	default:
 		thread_exit();
 		break;
@@ -256,6 +266,15 @@ int read(int fd, void *buffer, unsigned size)
 			exit(-1);
 		}
 	}
+	/* NOTE: [Improve] 아직 페이지가 만들어지지 않은 범위(VMA)도 검사 */
+	else
+	{
+		struct vma *vma = vma_find(&thread_current()->spt, buffer);
+		if (vma && !vma->writable)
+		{
+			exit(-1);
+		}
+	}
 
 	if (!is_user_vaddr(buffer) || buffer == NULL)
 	{
@@ -397,8 +416,9 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 	if (!is_user_vaddr(addr) || !is_user_vaddr(addr + length))
 		return NULL;
 
-	/* addr에 할당된 페이지가 이미 있는 경우 */
-	if (spt_find_page(&thread_current()->spt, addr))
+	/* addr부터 매핑할 범위에 할당된 페이지가 이미 있는 경우 */
+	/* NOTE: [Improve] 시작 페이지만이 아니라 범위 전체를 한 번에 검사 */
+	if (!spt_range_empty(&thread_current()->spt, addr, pg_round_up(addr + length)))
 		return NULL;
 
 	struct file *f = process_get_file(fd);
@@ -413,4 +433,16 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 
 	/* 위처럼 mmap이 이루어질 수 없는 case들을 제외하고는 do_mmap을 호출해 매핑 후 매핑된 가상주소 반환 */
 	return do_mmap(addr, length, writable, f, offset);
-}
\ No newline at end of file
+}
+/* NOTE: [Improve] addr이 매핑된 물리 주소 반환, 매핑이 없으면 NULL */
+/* copy-on-write 테스트(cow-simple)에서 부모와 자식이 같은 프레임을 쓰는지 확인할 때 사용 */
+static void *get_phys_addr(void *addr)
+{
+	void *kva;
+
+	if (!is_user_vaddr(addr))
+		return NULL;
+
+	kva = pml4_get_page(thread_current()->pml4, addr);
+	return kva != NULL ? (void *)vtop(kva) : NULL;
+}
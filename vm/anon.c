@@ -3,6 +3,11 @@
 #include "vm/vm.h"
 #include "devices/disk.h"
 #include "include/threads/mmu.h"
+#include "threads/synch.h"
+#include "intrinsic.h"
+#include <bitmap.h>
+#include <stdio.h>
+#include "threads/malloc.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -10,6 +15,44 @@ static bool anon_swap_in(struct page *page, void *kva);
 static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
+/* NOTE: [Improve] Swap slot 할당기.
+   slot마다 struct slot을 만들어 리스트로 훑는 대신, slot 번호를 인덱스로 쓰는
+   비트맵(1 = 사용 중)으로 관리한다. 할당은 마지막으로 준 slot 다음부터 찾는
+   next-fit이라, 보통은 힌트 바로 뒤에서 빈 칸을 찾는다. swap in/해제는 slot 번호로
+   비트 하나만 바꾸면 된다.
+
+   퇴거는 여러 페이지를 한꺼번에 연속된 slot에 이어서 쓰고(cluster), swap in 할 때는
+   바로 뒤 slot들 중 같은 주소 공간의 페이지를 남는 프레임이 있는 만큼 미리 읽는다
+   (readahead). 디스크 드라이버가 한 번에 한 섹터만 옮기므로 섹터들을 연달아 보낸다.
+
+   fork로 copy-on-write 공유 중인 프레임은 slot 하나에 한 번만 쓰고, 모든 sharer가
+   그 slot을 가리킨다. slot마다 가리키는 페이지 수를 세어서 마지막 페이지가 읽어 가거나
+   해제할 때 slot을 반환한다. */
+
+/* 페이지 하나를 담는 데 필요한 섹터 수 (4096 / 512 = 8) */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+/* swap in 할 때 미리 읽을 최대 페이지 수 */
+#define SWAP_READAHEAD 8
+
+static struct bitmap *swap_map; /* slot 사용 여부 */
+static struct page **slot_pages; /* slot에 저장된 페이지, readahead에서 사용 */
+static int *slot_refs;			 /* slot을 가리키는 페이지 수 */
+static size_t swap_hint;		/* 다음 할당을 찾기 시작할 slot */
+static struct lock swap_lock;	/* swap_map, swap_hint 보호 */
+
+/* 통계 */
+static long long swap_out_cnt;		 /* swap out 횟수 */
+static long long swap_alloc_cycles;	 /* slot 할당에 쓴 cycle 합 */
+static long long swap_out_cycles;	 /* swap out 전체에 쓴 cycle 합 */
+static long long swap_cluster_cnt;	 /* 연속 slot에 묶어 쓴 횟수 */
+static long long swap_readahead_cnt; /* 미리 읽은 페이지 수 */
+
+static uint32_t swap_slot_alloc(size_t cnt);
+static void swap_slot_free(uint32_t slot, struct page *page);
+static void swap_write(struct page *page, uint32_t slot);
+static void swap_readahead(uint32_t slot);
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
 	.swap_in = anon_swap_in,
@@ -24,27 +67,22 @@ void vm_anon_init(void)
 	/* TODO: Set up the swap_disk. */
 	swap_disk = disk_get(1, 1);
 
-	list_init(&swap_table);
-	lock_init(&swap_table_lock);
-
 	/* 1페이지 당 필요한 sector 개수?
 	hdd 경우 disk_sector가 512byte의 고정적 크기를 가짐
 	가상 페이지의 경우 4kb니까 총 8개의 disk_sector에 나뉘어 저장하게 됨 */
 
 	/* swap_size: 스왑 디스크 안에서 만들 수 있는 총 스왑 슬롯 개수
 	-> 스왑 공간 크기 / 1페이지 당 필요한 sector 개수 */
-	disk_sector_t swap_size = disk_size(swap_disk) / 8;
-	for (disk_sector_t i = 0; i < swap_size; i++)
-	{
-		/* 만들 수 있는 slot 개수 만큼 만들어 swap_table에 세팅 */
-		struct slot *slot = (struct slot *)malloc(sizeof(struct slot));
-		slot->page = NULL;
-		slot->slot_num = i;
-
-		lock_acquire(&swap_table_lock);
-		list_push_back(&swap_table, &slot->swap_elem);
-		lock_release(&swap_table_lock);
-	}
+	disk_sector_t swap_size = swap_disk != NULL ? disk_size(swap_disk) / SECTORS_PER_SLOT : 0;
+
+	/* NOTE: [Improve] slot 하나에 비트 하나 */
+	swap_map = bitmap_create(swap_size);
+	slot_pages = calloc(swap_size + 1, sizeof *slot_pages);
+	slot_refs = calloc(swap_size + 1, sizeof *slot_refs);
+	if (swap_map == NULL || slot_pages == NULL || slot_refs == NULL)
+		PANIC("vm_anon_init: cannot create swap map");
+	swap_hint = 0;
+	lock_init(&swap_lock);
 }
 
 /* Initialize the file mapping */
@@ -55,7 +93,8 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 
 	struct anon_page *anon_page = &page->anon;
 	/* anon_initializer가 호출되는 건 page가 매핑된 상태이므로 swap_slot을 차지하지 않는 상태 */
-	anon_page->slot_num = -1;
+	anon_page->slot_num = SWAP_SLOT_NONE;
+	anon_page->prefetch = false;
 	return true;
 }
 
@@ -65,33 +104,44 @@ anon_swap_in(struct page *page, void *kva)
 {
 	struct anon_page *anon_page = &page->anon;
 	/* swap_in 할 페이지가 저장된 slot num */
-	disk_sector_t page_slot_num = anon_page->slot_num;
-	struct list_elem *e;
-	struct slot *slot;
+	uint32_t slot = anon_page->slot_num;
+
+	if (slot == SWAP_SLOT_NONE)
+		return false;
 
-	lock_acquire(&swap_table_lock);
-	/* swap_table을 돌며 해당 slot num을 찾아 읽어오기 */
-	for (e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+	/* NOTE: [Improve] slot 번호로 바로 섹터 위치를 계산해 읽음 */
+	for (int i = 0; i < SECTORS_PER_SLOT; i++)
 	{
-		slot = list_entry(e, struct slot, swap_elem);
-		/* 타겟 페이지가 저장된 slot이라면 */
-		if (slot->slot_num == page_slot_num)
-		{
-			/* swap_disk에서 읽어와 kva+DISK_SECTOR_SIZE * i에 담음 */
-			for (int i = 0; i < 8; i++)
-			{
-				disk_read(swap_disk, page_slot_num * 8 + i, kva + DISK_SECTOR_SIZE * i);
-			}
-			/* 이제 swap in 했으니까 swap_table에서 제거 */
-			slot->page = NULL;
-			/* 해당 페이지는 이제 swap_table의 slot을 차지하지 않음 */
-			anon_page->slot_num = -1;
-			lock_release(&swap_table_lock);
-			return true;
-		}
+		disk_read(swap_disk, slot * SECTORS_PER_SLOT + i, kva + DISK_SECTOR_SIZE * i);
+	}
+
+	/* 이제 swap in 했으니까 slot 반환, 해당 페이지는 slot을 차지하지 않음 */
+	swap_slot_free(slot, page);
+	anon_page->slot_num = SWAP_SLOT_NONE;
+
+	/* NOTE: [Improve] 같은 cluster로 나갔던 뒤 페이지들도 미리 읽음.
+	   readahead로 읽히는 페이지(prefetch)라면 다시 readahead 하지 않는다 */
+	if (anon_page->prefetch)
+		anon_page->prefetch = false;
+	else
+		swap_readahead(slot + 1);
+	return true;
+}
+
+/* NOTE: [Improve] swap 된 PAGE의 내용을 slot은 그대로 둔 채 KVA로 읽음 */
+/* fork에서 부모의 swap 된 페이지를 자식에게 복사할 때 사용. 부모 페이지는 계속 swap에 남는다 */
+bool anon_read_slot(struct page *page, void *kva)
+{
+	uint32_t slot = page->anon.slot_num;
+
+	if (slot == SWAP_SLOT_NONE)
+		return false;
+
+	for (int i = 0; i < SECTORS_PER_SLOT; i++)
+	{
+		disk_read(swap_disk, slot * SECTORS_PER_SLOT + i, kva + DISK_SECTOR_SIZE * i);
 	}
-	lock_release(&swap_table_lock);
-	return false;
+	return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
@@ -103,38 +153,148 @@ anon_swap_out(struct page *page)
 		return false;
 	}
 
-	struct anon_page *anon_page = &page->anon;
+	uint64_t start = rdtsc();
+	uint32_t slot = swap_slot_alloc(1);
+
+	if (slot == SWAP_SLOT_NONE)
+		PANIC("No more empty slots on disk");
+
+	/* 쓰는 도중에 내용이 바뀌지 않도록 먼저 매핑을 지움 */
+	pml4_clear_page(page->owner->pml4, page->va);
+	swap_write(page, slot);
+
+	swap_out_cnt++;
+	swap_out_cycles += rdtsc() - start;
+	return true;
+}
+
+/* NOTE: [Improve] 퇴거할 anon 페이지 PAGES[0..CNT)를 연속된 slot에 이어서 swap out */
+/* 연속된 빈 slot이 없으면 한 페이지씩 내보낸다 */
+void anon_swap_out_cluster(struct page **pages, size_t cnt)
+{
+	uint64_t start = rdtsc();
+	uint32_t base = swap_slot_alloc(cnt);
+	size_t i;
+
+	if (base == SWAP_SLOT_NONE)
+	{
+		for (i = 0; i < cnt; i++)
+			anon_swap_out(pages[i]);
+		return;
+	}
+
+	/* 먼저 모든 매핑을 지운 뒤 섹터들을 연달아 씀 */
+	for (i = 0; i < cnt; i++)
+		pml4_clear_page(pages[i]->owner->pml4, pages[i]->va);
+	for (i = 0; i < cnt; i++)
+		swap_write(pages[i], base + i);
+
+	swap_out_cnt += cnt;
+	swap_cluster_cnt++;
+	swap_out_cycles += rdtsc() - start;
+}
+
+/* NOTE: [Improve] copy-on-write로 공유 중인 FRAME을 slot 하나에 한 번만 써서 내보냄 */
+/* 남아 있는 sharer 모두가 그 slot을 가리키게 되고, 각자 다음 접근 때 자기 프레임으로 읽는다.
+   쓰는 동안 sharer가 종료해도 프레임이 해제되지 않도록 참조를 하나 잡아 두고, 끝나면
+   FRAME은 참조 1개짜리 빈 프레임이 된다. 모든 매핑이 읽기 전용이라 쓰는 동안 내용은 그대로다 */
+void anon_swap_out_shared(struct frame *frame)
+{
+	uint64_t start = rdtsc();
+	uint32_t slot = swap_slot_alloc(1);
 	struct list_elem *e;
-	struct slot *slot;
+	struct page *page;
+	int cnt = 0;
+
+	if (slot == SWAP_SLOT_NONE)
+		PANIC("No more empty slots on disk");
+
+	lock_acquire(&frame_table_lock);
+	frame->ref_cnt++;
+	for (e = list_begin(&frame->sharers); e != list_end(&frame->sharers); e = list_next(e))
+	{
+		page = list_entry(e, struct page, sharer_elem);
+		pml4_clear_page(page->owner->pml4, page->va);
+	}
+	lock_release(&frame_table_lock);
+
+	for (int i = 0; i < SECTORS_PER_SLOT; i++)
+	{
+		disk_write(swap_disk, slot * SECTORS_PER_SLOT + i, frame->kva + DISK_SECTOR_SIZE * i);
+	}
+
+	/* 그동안 다시 매핑된 sharer가 있을 수 있으므로 매핑을 한 번 더 지움 */
+	lock_acquire(&frame_table_lock);
+	lock_acquire(&swap_lock);
+	slot_pages[slot] = frame->page;
+	while (!list_empty(&frame->sharers))
+	{
+		page = list_entry(list_pop_front(&frame->sharers), struct page, sharer_elem);
+		pml4_clear_page(page->owner->pml4, page->va);
+		page->anon.slot_num = slot;
+		page->frame = NULL;
+		cnt++;
+	}
+	slot_refs[slot] = cnt;
+	if (cnt == 0) /* 쓰는 동안 모두 종료함 */
+		bitmap_reset(swap_map, slot);
+	lock_release(&swap_lock);
+	frame->page = NULL;
+	frame->ref_cnt = 1;
+	lock_release(&frame_table_lock);
+
+	swap_out_cnt++;
+	swap_out_cycles += rdtsc() - start;
+}
+
+/* NOTE: [Improve] 매핑이 지워진 PAGE의 내용을 SLOT에 쓰고 프레임과의 연결을 끊음 */
+static void
+swap_write(struct page *page, uint32_t slot)
+{
+	/* 해당 슬롯에 page의 내용 저장 */
+	for (int i = 0; i < SECTORS_PER_SLOT; i++)
+	{
+		/* 다른 프로세스의 페이지일 수 있으므로 va 대신 kva에서 */
+		disk_write(swap_disk, slot * SECTORS_PER_SLOT + i, page->frame->kva + DISK_SECTOR_SIZE * i);
+	}
+
+	/* 페이지에 슬롯 번호 저장 */
+	page->anon.slot_num = slot;
+	lock_acquire(&swap_lock);
+	slot_pages[slot] = page;
+	slot_refs[slot] = 1;
+	lock_release(&swap_lock);
+
+	/* page와 매핑되어있었던 frame과의 연결 끊기 */
+	page->frame->page = NULL;
+	page->frame = NULL;
+}
+
+/* NOTE: [Improve] SLOT부터 이어지는 slot의 페이지 중 현재 프로세스의 것을 미리 읽음 */
+/* 남는 프레임이 없거나 다른 주소 공간의 페이지를 만나면 멈춘다.
+   readahead 중이라는 표시는 읽는 페이지마다 달아서, 다른 쓰레드의 swap in과 섞이지 않는다 */
+static void
+swap_readahead(uint32_t slot)
+{
+	struct thread *curr = thread_current();
+	struct page *page;
 
-	lock_acquire(&swap_table_lock);
-	/* swap_table을 돌며 빈 슬롯을 찾아 페이지 저장(First-Fit) */
-	for (e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+	for (size_t i = 0; i < SWAP_READAHEAD && slot + i < bitmap_size(swap_map); i++)
 	{
-		slot = list_entry(e, struct slot, swap_elem);
-		/* slot의 page가 NULL인 슬롯 = 빈 슬롯 */
-		if (slot->page == NULL)
+		lock_acquire(&swap_lock);
+		page = slot_pages[slot + i];
+		lock_release(&swap_lock);
+
+		if (page == NULL || page->owner != curr || page->frame != NULL)
+			break;
+		page->anon.prefetch = true;
+		if (!vm_prefetch_page(page, true))
 		{
-			/* 해당 슬롯에 page의 내용 저장 */
-			for (int i = 0; i < 8; i++)
-			{
-				disk_write(swap_disk, slot->slot_num * 8 + i, page->va + DISK_SECTOR_SIZE * i);
-			}
-
-			/* 페이지에 swap_table 위치(슬롯 번호) 저장 & slot->page에 해당 페이지 저장 */
-			anon_page->slot_num = slot->slot_num;
-			slot->page = page;
-			/* page와 매핑되어있었던 frame과의 연결 끊기 */
-			page->frame->page = NULL;
-			page->frame = NULL;
-			/* 가상 메모리 목록에서도 지우기 */
-			pml4_clear_page(thread_current()->pml4, page->va);
-			lock_release(&swap_table_lock);
-			return true;
+			page->anon.prefetch = false;
+			break;
 		}
+		swap_readahead_cnt++;
 	}
-	lock_release(&swap_table_lock);
-	PANIC("No more empty slots on disk");
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
@@ -142,19 +302,60 @@ static void
 anon_destroy(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
-	struct list_elem *e;
-	struct slot *slot;
 
-	lock_acquire(&swap_table_lock);
-	for (e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+	/* NOTE: [Improve] swap 된 페이지라면 slot 반환 */
+	if (anon_page->slot_num != SWAP_SLOT_NONE)
 	{
-		slot = list_entry(e, struct slot, swap_elem);
+		swap_slot_free(anon_page->slot_num, page);
+		anon_page->slot_num = SWAP_SLOT_NONE;
+	}
+	/* NOTE: [Improve] 프레임 참조를 내려놓음, 마지막 참조라면 프레임도 해제 */
+	vm_release_frame(page);
+}
 
-		if (slot->slot_num == anon_page->slot_num)
-		{
-			slot->page = NULL;
-			break;
-		}
+/* NOTE: [Improve] 연속된 빈 slot CNT개를 할당해 첫 번호를 반환, 없으면 SWAP_SLOT_NONE */
+/* swap_hint부터 끝까지 찾고, 없으면 처음부터 다시 찾는다 (next-fit) */
+static uint32_t
+swap_slot_alloc(size_t cnt)
+{
+	uint64_t start = rdtsc();
+	size_t slot;
+
+	lock_acquire(&swap_lock);
+	slot = bitmap_scan_and_flip(swap_map, swap_hint, cnt, false);
+	if (slot == BITMAP_ERROR && swap_hint != 0)
+		slot = bitmap_scan_and_flip(swap_map, 0, cnt, false);
+	if (slot != BITMAP_ERROR)
+		swap_hint = slot + cnt < bitmap_size(swap_map) ? slot + cnt : 0;
+	swap_alloc_cycles += rdtsc() - start;
+	lock_release(&swap_lock);
+
+	return slot != BITMAP_ERROR ? slot : SWAP_SLOT_NONE;
+}
+
+/* NOTE: [Improve] PAGE가 SLOT을 더 이상 가리키지 않음. 마지막 페이지였다면 SLOT을 반환 */
+static void
+swap_slot_free(uint32_t slot, struct page *page)
+{
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_test(swap_map, slot));
+	ASSERT(slot_refs[slot] > 0);
+	if (slot_pages[slot] == page)
+		slot_pages[slot] = NULL;
+	if (--slot_refs[slot] == 0)
+	{
+		bitmap_reset(swap_map, slot);
+		slot_pages[slot] = NULL;
 	}
-	lock_release(&swap_table_lock);
+	lock_release(&swap_lock);
+}
+
+/* NOTE: [Improve] swap 통계 출력 */
+void vm_anon_print_stats(void)
+{
+	printf("Swap: %zu slots, %lld swap-outs in %lld clusters, %lld pages read ahead, "
+		   "%lld cycles per slot allocation, %lld cycles per swap-out\n",
+		   bitmap_size(swap_map), swap_out_cnt, swap_cluster_cnt, swap_readahead_cnt,
+		   swap_out_cnt ? swap_alloc_cycles / swap_out_cnt : 0,
+		   swap_out_cnt ? swap_out_cycles / swap_out_cnt : 0);
 }
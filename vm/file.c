@@ -37,6 +37,7 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva)
 	file_page->ofs = lazy_load_arg->ofs;
 	file_page->read_bytes = lazy_load_arg->read_bytes;
 	file_page->zero_bytes = lazy_load_arg->zero_bytes;
+	return true;
 }
 
 /* Swap in the page by read contents from the file. */
@@ -54,17 +55,20 @@ file_backed_swap_out(struct page *page)
 {
 	struct file_page *file_page UNUSED = &page->file;
 
+	/* NOTE: [Improve] 퇴거는 다른 프로세스의 페이지에도 일어나므로 owner의 pml4와 kva를 사용 */
+	uint64_t *pml4 = page->owner->pml4;
+
 	/* 수정사항이 있었다면 파일(in disk)에 수정사항 적용해주고, dirty bit = 0으로 초기화 */
-	if (pml4_is_dirty(thread_current()->pml4, page->va))
+	if (pml4_is_dirty(pml4, page->va))
 	{
-		file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->ofs);
-		pml4_set_dirty(thread_current()->pml4, page->va, 0);
+		file_write_at(file_page->file, page->frame->kva, file_page->read_bytes, file_page->ofs);
+		pml4_set_dirty(pml4, page->va, 0);
 	}
 
 	/* 페이지와 프레임 연결 끊음 */
 	page->frame->page = NULL;
 	page->frame = NULL;
-	pml4_clear_page(thread_current()->pml4, page->va);
+	pml4_clear_page(pml4, page->va);
 	return true;
 }
 
@@ -75,14 +79,16 @@ file_backed_destroy(struct page *page)
 	struct file_page *file_page UNUSED = &page->file;
 
 	/* 수정사항이 있었다면 file_write_at으로 반영하고 dirty를 0으로 수정 */
-	if (pml4_is_dirty(thread_current()->pml4, page->va))
+	/* NOTE: [Improve] 이미 프레임을 내려놓은 페이지(munmap 이후)는 다시 쓰지 않음 */
+	if (page->frame != NULL && pml4_is_dirty(thread_current()->pml4, page->va))
 	{
 		file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->ofs);
 		pml4_set_dirty(thread_current()->pml4, page->va, 0);
 	}
 
 	/* 가상페이지 목록에서 제거 */
-	pml4_clear_page(thread_current()->pml4, page->va);
+	/* NOTE: [Improve] 매핑을 지우고 프레임 참조를 내려놓음 */
+	vm_release_frame(page);
 }
 
 /* Do the mmap */
@@ -90,76 +96,30 @@ void *
 do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset)
 {
-	/* reopen()으로 해당 파일에 대한 새로운 파일 디스크립터 얻음 */
-	struct file *f = file_reopen(file);
-	/* 매핑 성공 시 반환할 가상 주소 */
-	void *start_addr = addr;
-
-	/* 매핑에 쓰인 총 페이지 수 */
-	int total_page_count;
-
-	/* 읽어올 길이가 PGSIZE보다 작을 시 페이지 수 1개 */
-	if (length <= PGSIZE)
-		total_page_count = 1;
-	/* 일어올 길이가 PGSIZE로 나누어 떨어지지 않는다면 남은 부분을 적재하기 위해 나눈 몫에 +1 */
-	else if (length % PGSIZE != 0)
-		total_page_count = length / PGSIZE + 1;
-	/* 일어올 길이가 PGSIZE로 나누어 떨어진다면 페이지 수는 나눈 몫 */
-	else
-		total_page_count = length / PGSIZE;
-
-	size_t read_bytes = file_length(f) < length ? file_length(f) : length;
-	size_t zero_bytes = PGSIZE - read_bytes % PGSIZE;
-
-	ASSERT((read_bytes + zero_bytes) % PGSIZE == 0);
+	/* 파일에서 읽어 올 길이, 나머지 부분은 0으로 채움 */
+	size_t read_bytes = file_length(file) < length ? file_length(file) : length;
+
 	ASSERT(pg_ofs(addr) == 0);	  // upage 페이지 정렬 확인
 	ASSERT(offset % PGSIZE == 0); // offset 페이지 정렬 확인
 
-	while (read_bytes > 0 || zero_bytes > 0)
-	{
-		/* 페이지 채우기 */
-		/* page_read_bytes만큼을 읽고, page_zero_bytes만큼을 0으로 채움 */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		struct lazy_load_arg *lazy_load_arg = (struct lazy_load_arg *)malloc(sizeof(struct lazy_load_arg));
-		lazy_load_arg->file = f;
-		lazy_load_arg->ofs = offset;
-		lazy_load_arg->read_bytes = page_read_bytes;
-		lazy_load_arg->zero_bytes = page_zero_bytes;
-
-		/* vm_alloc_page_with_initializer로 lazy loading할 페이지 생성 (type은 file-backed) */
-		if (!vm_alloc_page_with_initializer(VM_FILE, addr, writable, lazy_load_segment, lazy_load_arg))
-			return NULL;
-
-		struct page *p = spt_find_page(&thread_current()->spt, start_addr);
-		p->mapped_page_cnt = total_page_count;
-
-		/* read bytes와 zero_bytes 감소시키고 가상 주소 증가 */
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		addr += PGSIZE;
-		offset += page_read_bytes;
-	}
-	return start_addr;
+	/* NOTE: [Improve] 페이지마다 struct page를 만들지 않고 범위 하나(VMA)로 등록.
+	   페이지는 처음 접근할 때 vma_fault()에서 만든다.
+	   VMA가 reopen()으로 파일을 따로 열어 두므로 원래 fd를 닫아도 매핑은 유지됨 */
+	if (!vma_map(&thread_current()->spt, addr, length, file, offset, read_bytes,
+				 VM_FILE, writable, true))
+		return NULL;
+	return addr;
 }
 
 /* Do the munmap */
 void do_munmap(void *addr)
 {
 	struct supplemental_page_table *spt = &thread_current()->spt;
-	struct page *p = spt_find_page(spt, addr);
-	/* 같은 파일이 매핑된 페이지가 모두 해제되도록 총 매핑된 페이지 수를 가져와 전부 해제 */
-	/* destroy 호출로 file_backed_destroy에서 파일의 수정사항을 기록하고 가상 페이지 목록에서 해당 페이지가 제거되도록 함 */
-	int mapped_pages = p->mapped_page_cnt;
+	struct vma *vma = vma_find(spt, addr);
 
-	for (int i = 0; i < mapped_pages; i++)
-	{
-		if (p)
-		{
-			destroy(p);
-		}
-		addr += PGSIZE;
-		p = spt_find_page(spt, addr);
-	}
+	/* NOTE: [Improve] addr에서 시작하는 mmap 범위를 한 번에 해제 */
+	/* destroy 호출로 file_backed_destroy에서 파일의 수정사항을 기록하고 가상 페이지 목록에서 해당 페이지가 제거되도록 함 */
+	if (vma == NULL || !vma->mmap || vma->start != addr)
+		return;
+	vma_unmap(spt, vma);
 }
@@ -1,6 +1,8 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include <string.h>
 #include "vm/vm.h"
 #include "vm/inspect.h"
 #include "include/lib/kernel/hash.h"
@@ -8,6 +10,50 @@
 #include "include/threads/vaddr.h"
 #include "include/threads/mmu.h"
 #include "include/userprog/process.h"
+#include "filesys/inode.h"
+#include "devices/timer.h"
+#include <round.h>
+#include <stdio.h>
+
+/* NOTE: [Improve] 한 번의 퇴거에서 함께 디스크에 쓸 최대 프레임 수 */
+#define EVICT_CLUSTER 8
+
+/* NOTE: [Improve] 자주 만들고 지우는 VM 구조체를 위한 slab cache */
+static struct kmem_cache *page_struct_cache;
+
+/* NOTE: [Improve] Frame table.
+   user pool의 물리 페이지마다 struct frame을 하나씩 미리 만들어 배열로 둔다.
+   frames[i]는 user pool의 i번째 페이지이고, kva가 NULL이면 쓰지 않는 칸이다.
+   CLOCK 바늘(clock_hand)은 배열 인덱스라서 프레임이 해제되어도 무효가 되지 않는다.
+   frame_table_lock으로 보호 */
+static struct frame *frames;
+static size_t frame_cnt;
+static size_t clock_hand;
+
+/* dirty 후보를 찾은 뒤 clean 프레임을 더 찾아볼 최대 칸 수 */
+#define CLEAN_SEARCH 16
+
+/* 통계 */
+static long long evict_cnt;		  /* 퇴거한 프레임 수 */
+static long long evict_dirty_cnt; /* 그중 디스크에 써야 했던 프레임 수 */
+static long long evict_scan_cnt;  /* 퇴거 대상을 찾으며 살펴본 칸 수 */
+
+/* NOTE: [Improve] 읽기 전용 파일 페이지를 담은 프레임의 (inode, ofs) 해시 테이블.
+   같은 실행 파일을 띄운 프로세스들은 text 프레임 하나를 함께 매핑한다.
+   frame_table_lock으로 보호 */
+static struct hash share_table;
+
+/* NOTE: [Improve] share table 검색 key. 프레임 전체를 만들지 않고 hash_find_key()로 찾는다 */
+struct share_key
+{
+	struct inode *inode;
+	off_t ofs;
+};
+static uint64_t share_hash(const struct hash_elem *e, void *aux);
+static bool share_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+static uint64_t share_key_hash(const struct share_key *key);
+static bool share_match(const struct hash_elem *e, const void *key, void *aux);
+static struct frame *share_find(struct inode *inode, off_t ofs);
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -21,8 +67,19 @@ void vm_init(void)
 	register_inspect_intr();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
-	list_init(&frame_table);
 	lock_init(&frame_table_lock);
+	hash_init(&share_table, share_hash, share_less, NULL);
+
+	/* NOTE: [Improve] user pool 크기만큼 frame 배열을 만듦 */
+	frame_cnt = palloc_user_page_cnt();
+	frames = palloc_get_multiple(PAL_ZERO, DIV_ROUND_UP(frame_cnt * sizeof *frames, PGSIZE));
+	if (frames == NULL)
+		PANIC("vm_init: cannot allocate frame table");
+	clock_hand = 0;
+
+	page_struct_cache = kmem_cache_create("page", sizeof(struct page), NULL);
+	if (page_struct_cache == NULL)
+		PANIC("vm_init: cannot create slab caches");
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -42,9 +99,34 @@ page_get_type(struct page *page)
 }
 
 /* Helpers */
-static struct frame *vm_get_victim(void);
+static size_t vm_get_victims(struct frame **victims, size_t max);
+static struct frame *vm_get_frame(void);
 static bool vm_do_claim_page(struct page *page);
 static struct frame *vm_evict_frame(void);
+static struct frame *vm_frame_create(void *kva);
+static struct page **spt_slot(struct supplemental_page_table *spt, const void *va, bool create);
+
+/* NOTE: [Improve] supplemental_page_table_copy()의 순회 인자 */
+struct spt_copy_aux
+{
+	struct supplemental_page_table *dst;
+	struct supplemental_page_table *src;
+};
+static bool spt_copy_page(struct page *src_page, void *aux);
+static bool vm_frame_evictable(struct frame *frame);
+static bool vm_frame_needs_write(struct frame *frame);
+static bool vm_frame_test_accessed(struct frame *frame);
+static void vm_frame_unref(struct frame *frame);
+static void vm_frame_add_sharer(struct frame *frame, struct page *page);
+static bool page_share_key(struct page *page, struct inode **inode,
+						   off_t *ofs, uint32_t *read_bytes);
+static bool vm_share_map(struct page *page, struct inode *inode,
+						 off_t ofs, uint32_t read_bytes);
+static void vm_share_insert(struct frame *frame, struct inode *inode,
+							off_t ofs, uint32_t read_bytes);
+static void vm_share_evict(struct frame *frame);
+static void vm_file_evict_shared(struct frame *frame);
+static struct inode *vm_share_drop(struct frame *frame);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -63,7 +145,9 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 	if (spt_find_page(spt, upage) == NULL)
 	{
 		/* 페이지 생성 */
-		struct page *p = (struct page *)malloc(sizeof(struct page));
+		struct page *p = kmem_cache_alloc(page_struct_cache);
+		if (p == NULL)
+			goto err;
 
 		/* 페이지 타입에 따라 초기화 함수를 가져와 담기 */
 		bool (*page_initializer)(struct page *, enum vm_type, void *);
@@ -86,6 +170,9 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		/* 필드 값을 수정할 땐 uninit 호출 이후에 해야 한다 = uninit_new 함수 안에서 구조체 내용이 모두 새로 할당되기 때문에 */
 		p->writable = writable;
 
+		/* NOTE: [Improve] 퇴거할 때 어느 pml4에서 매핑을 지울지 알 수 있도록 */
+		p->owner = thread_current();
+
 		/* 생성한 페이지 spt에 추가 */
 		return spt_insert_page(spt, p);
 	}
@@ -98,19 +185,15 @@ err:
 struct page *
 spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
 {
-	struct page *page = NULL;
-	/* TODO: Fill this function. */
-	page = malloc(sizeof(struct page));
-	struct hash_elem *e;
-
-	/* 할당한 page의 va 값 할당 후, 해당 va에 해당하는 elem 찾기 */
-	/* pg_round_down: 가장 가까운 페이지 경계로 반올림 */
-	/* 사용자가 원하는 임의의 가상 주소에 접근 시, 해당 주소가 포함된 page의 시작 주소를 찾기 위해 진행 */
-	page->va = pg_round_down(va);
-	e = hash_find(&spt->spt_hash, &page->bucket_elem);
-	free(page);
-	/* 해당하는 hash_elem이 있으면, 그 hash_entry로 해당 페이지 반환 */
-	return e != NULL ? hash_entry(e, struct page, bucket_elem) : NULL;
+	/* NOTE: [Improve] radix tree를 pml4처럼 4단계 내려가 leaf 칸을 찾는다 */
+	struct page **slot;
+
+	/* 사용자가 원하는 임의의 가상 주소에 접근 시, 해당 주소가 포함된 page를 찾음
+	   (leaf 칸은 페이지 단위라 pg_round_down이 따로 필요 없음) */
+	if (!is_user_vaddr(va))
+		return NULL;
+	slot = spt_slot(spt, va, false);
+	return slot != NULL ? *slot : NULL;
 }
 
 /* Insert PAGE into spt with validation. */
@@ -118,139 +201,435 @@ spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
 bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
 					 struct page *page UNUSED)
 {
-	/* 유효성 검사?: 동일한 va값이 있으면 안 되기 때문에 spt에 삽입할 page의 va값이 있는지 검사 = hash_insert에서 해줌 */
+	/* 유효성 검사: 동일한 va값이 있으면 안 되기 때문에 해당 칸이 비어있는지 검사 */
+	struct page **slot = spt_slot(spt, page->va, true);
 
-	/* hash_insert를 해서 동일 va값이 없었다면, 즉 반환값이 NULL이라면 삽입 성공 true 반환 */
-	/* 동일한 va값이 존재한다면, 반환값이 NULL이 아니기 떄문에 false 반환 */
-	return hash_insert(&spt->spt_hash, &page->bucket_elem) == NULL ? true : false;
+	if (slot == NULL || *slot != NULL)
+		return false;
+	*slot = page;
+	spt->page_cnt++;
+	return true;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
-	// hash_delete(&spt->spt_hash, &page->bucket_elem);
+	/* NOTE: [Improve] 트리에서 빼고 해제 */
+	struct page **slot = spt_slot(spt, page->va, false);
+
+	ASSERT(slot != NULL && *slot == page);
+	*slot = NULL;
+	spt->page_cnt--;
 	vm_dealloc_page(page);
-	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
-static struct frame *
-vm_get_victim(void)
+/* NOTE: [Improve] Supplemental page table = 4단계 radix tree.
+   x86-64 pml4와 같은 모양으로, va의 PML4/PDPE/PDX/PTX 인덱스(각 9비트)를 따라
+   512칸짜리 노드(한 페이지)를 내려가고, 마지막 단계 노드의 칸에 struct page *가 있다.
+   그래서 찾기는 항상 메모리 접근 4번이고, 인접한 페이지는 같은 leaf 노드에 모여 있어서
+   범위 순회/삽입/삭제와 copy/kill이 va 순서대로 도는 선형 순회가 된다.
+   중간 노드는 필요할 때 만들고, 범위 삭제로 통째로 빈 노드는 바로 반환한다. */
+
+/* VA가 LEVEL(0 = 최상위) 노드에서 가리키는 칸 번호 */
+static inline size_t
+spt_idx(uint64_t va, int level)
 {
-	struct frame *victim = NULL;
+	return (va >> (PML4SHIFT - SPT_BITS * level)) & (SPT_ENTRIES - 1);
+}
 
-	struct thread *curr = thread_current();
+/* VA의 leaf 칸 주소를 반환. CREATE면 없는 노드를 만들고, 실패하거나 노드가 없으면 NULL */
+static struct page **
+spt_slot(struct supplemental_page_table *spt, const void *va, bool create)
+{
+	void **node;
 
-	lock_acquire(&frame_table_lock);
-	struct list_elem *start = list_begin(&frame_table);
-	for (start; start != list_end(&frame_table); start = list_next(start))
+	if (spt->root == NULL)
 	{
-		victim = list_entry(start, struct frame, frame_elem);
+		if (!create || (spt->root = palloc_get_page(PAL_ZERO)) == NULL)
+			return NULL;
+	}
 
-		if (victim->page == NULL)
+	node = spt->root;
+	for (int level = 0; level < SPT_LEVELS - 1; level++)
+	{
+		void **next = &node[spt_idx((uint64_t)va, level)];
+		if (*next == NULL)
 		{
-			lock_release(&frame_table_lock);
-			return victim;
+			if (!create || (*next = palloc_get_page(PAL_ZERO)) == NULL)
+				return NULL;
 		}
-		/* frame table의 entry page가 최근에 access 된 경우 = accessed bit(1) = true 반환 */
-		if (pml4_is_accessed(curr->pml4, victim->page->va))
+		node = *next;
+	}
+	return (struct page **)&node[spt_idx((uint64_t)va, SPT_LEVELS - 1)];
+}
+
+/* LEVEL 단계 노드 NODE(BASE부터 시작하는 영역)에서 [START, END)에 든 페이지를
+   va 순서대로 방문. REMOVE면 방문한 칸을 비우고, 범위에 통째로 든 하위 노드는 반환.
+   ACTION이 false를 반환하면 멈추고 false 반환 */
+static bool
+spt_walk(struct supplemental_page_table *spt, void **node, int level, uint64_t base,
+		 uint64_t start, uint64_t end, spt_action_func *action, void *aux, bool remove)
+{
+	uint64_t shift = PML4SHIFT - SPT_BITS * level;
+	uint64_t span = 1ULL << shift;
+	size_t i = start > base ? (start - base) >> shift : 0;
+
+	for (; i < SPT_ENTRIES; i++)
+	{
+		uint64_t lo = base + i * span;
+
+		if (lo >= end)
+			break;
+		if (node[i] == NULL)
+			continue;
+
+		if (level == SPT_LEVELS - 1)
 		{
-			/* set_accessed로 accessed bit를 1에서 0으로 설정한 후 넘어감 */
-			pml4_set_accessed(curr->pml4, victim->page->va, 0);
+			struct page *page = node[i];
+			if (remove)
+			{
+				node[i] = NULL;
+				spt->page_cnt--;
+			}
+			if (action != NULL && !action(page, aux))
+				return false;
 		}
 		else
 		{
-			/* 최근에 accessed 된 경우가 아니라면, accessed bit(0) = swap out될 대상이 됨 */
-			lock_release(&frame_table_lock);
-			start = 교체되는 애의 다음 애 return victim;
+			if (!spt_walk(spt, node[i], level + 1, lo, start, end, action, aux, remove))
+				return false;
+			if (remove && start <= lo && lo + span <= end)
+			{
+				palloc_free_page(node[i]);
+				node[i] = NULL;
+			}
 		}
 	}
+	return true;
+}
 
-	lock_release(&frame_table_lock);
-	return victim;
+/* NOTE: [Improve] [START, END)의 페이지마다 va 순서대로 ACTION 호출 */
+/* ACTION이 false를 반환하면 멈추고 false 반환, 끝까지 돌면 true */
+bool spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux)
+{
+	if (spt->root == NULL)
+		return true;
+	return spt_walk(spt, spt->root, 0, 0, (uint64_t)start, (uint64_t)end, action, aux, false);
+}
+
+/* NOTE: [Improve] PAGES[0..CNT)를 한꺼번에 삽입, 하나라도 실패하면 넣은 것을 모두 되돌림 */
+bool spt_insert_range(struct supplemental_page_table *spt, struct page **pages, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++)
+	{
+		if (!spt_insert_page(spt, pages[i]))
+		{
+			while (i-- > 0)
+			{
+				*spt_slot(spt, pages[i]->va, false) = NULL;
+				spt->page_cnt--;
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool
+spt_dealloc(struct page *page, void *aux UNUSED)
+{
+	vm_dealloc_page(page);
+	return true;
+}
+
+/* NOTE: [Improve] [START, END)의 페이지를 모두 트리에서 빼고 해제 (destroy 호출) */
+void spt_remove_range(struct supplemental_page_table *spt, void *start, void *end)
+{
+	if (spt->root != NULL)
+		spt_walk(spt, spt->root, 0, 0, (uint64_t)start, (uint64_t)end, spt_dealloc, NULL, true);
+}
+
+static bool
+spt_stop(struct page *page UNUSED, void *aux UNUSED)
+{
+	return false;
+}
+
+/* NOTE: [Improve] [START, END)에 페이지가 하나도 없으면 true (mmap 겹침 검사용) */
+bool spt_range_empty(struct supplemental_page_table *spt, void *start, void *end)
+{
+	return spt_for_each(spt, start, end, spt_stop, NULL);
 }
 
 /* Evict one page and return the corresponding frame.
  * Return NULL on error.*/
 /* 하나의 페이지를 퇴거 시키고 해당 프레임 반환 */
+/* NOTE: [Improve] CLOCK 한 바퀴에서 고른 dirty 후보들은 EVICT_CLUSTER개까지 함께 내보낸다.
+   anon 페이지들은 연속된 swap slot에 이어서 쓰고, 첫 프레임만 바로 재사용하고
+   나머지는 palloc에 돌려줘서 다음 fault들이 퇴거 없이 프레임을 받도록 한다 */
 static struct frame *
 vm_evict_frame(void)
 {
-	/* vm_get_victim으로 퇴거할 페이지를 골라 반환받은 후 */
-	struct frame *victim UNUSED = vm_get_victim();
+	struct frame *victims[EVICT_CLUSTER];
+	struct page *anon_pages[EVICT_CLUSTER];
+	size_t victim_cnt, anon_cnt = 0, i;
+
+	/* vm_get_victims로 퇴거할 페이지들을 골라 반환받은 후 */
+	victim_cnt = vm_get_victims(victims, EVICT_CLUSTER);
+	if (victim_cnt == 0)
+		return NULL;
+
 	/* TODO: swap out the victim and return the evicted frame. */
-	if (victim->page)
+	/* NOTE: [Improve] 공유 중인 파일 프레임은 모든 sharer의 매핑을 지움.
+	   파일 페이지를 써서 vm_share_invalidate()가 불리기 전에 share table에서 먼저 뺀다 */
+	for (i = 0; i < victim_cnt; i++)
+		if (victims[i]->inode != NULL)
+			vm_share_evict(victims[i]);
+
+	for (i = 0; i < victim_cnt; i++)
 	{
-		/* 해당 페이지를 swap out 시킴 */
-		swap_out(victim->page);
+		struct frame *victim = victims[i];
+
+		if (victim->page == NULL) /* 위에서 퇴거한 공유 프레임 */
+			continue;
+		/* NOTE: [Improve] fork로 공유 중인 프레임은 한 번만 써서 모든 sharer를 떼어냄 */
+		if (!list_empty(&victim->sharers))
+		{
+			if (VM_TYPE(victim->page->operations->type) == VM_ANON)
+				anon_swap_out_shared(victim);
+			else
+				vm_file_evict_shared(victim);
+		}
+		else if (VM_TYPE(victim->page->operations->type) == VM_ANON)
+			anon_pages[anon_cnt++] = victim->page;
+		else
+			/* 해당 페이지를 swap out 시킴 */
+			swap_out(victim->page);
 	}
+	if (anon_cnt > 0)
+		anon_swap_out_cluster(anon_pages, anon_cnt);
+
+	for (i = 1; i < victim_cnt; i++)
+		vm_frame_unref(victims[i]);
+
 	/* 이제 빈 공간이 된 프레임 반환 */
-	return victim;
+	return victims[0];
 }
 
-/* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
-static struct frame *
-vm_get_victim(void)
+/* Get the struct frame, that will be evicted. */
+/* NOTE: [Improve] 페이지 교체 정책: 모든 프로세스의 프레임에 대한 CLOCK (second chance) */
+/* 바늘이 가리키는 프레임의 accessed bit가 1이면 0으로 지우고 넘어가고, 0이면 퇴거 대상.
+   디스크에 써야 하는 프레임(anon, 수정된 file 페이지)보다 그냥 버려도 되는 clean 프레임을
+   선호해서, dirty 후보를 찾은 뒤에도 CLEAN_SEARCH칸까지 clean 후보를 더 찾아본다.
+   clean 후보를 찾으면 그 하나만, 못 찾으면 그동안 지나친 dirty 후보를 MAX개까지
+   VICTIMS에 담아 개수를 반환한다 (디스크 쓰기를 묶기 위해).
+   첫 바퀴에서 accessed bit를 모두 지우므로 두 바퀴 안에는 후보가 나온다.
+   모든 프레임이 고정되어 있거나 채워지는 중이라면 0을 반환한다 */
+static size_t
+vm_get_victims(struct frame **victims, size_t max)
 {
-	struct frame *victim = NULL;
-
-	struct thread *curr = thread_current();
+	struct frame *clean = NULL;
+	size_t dirty_cnt = 0;
+	size_t scanned = 0, dirty_scanned = 0;
 
 	lock_acquire(&frame_table_lock);
+	while (scanned < 2 * frame_cnt)
+	{
+		struct frame *frame;
 
-	/* 페이지 교체 정책: clock_algorithm */
-	/* evict_start: 최근에 교체됐던 페이지의 다음 페이지 */
-	/* temp를 두는 이유: evict_start 그 자체로 탐색을 하면 첫 번째 for문을 다 돈 다음
-					  다음 for문에서 어디까지 돌아야 할 지 애매해짐 = temp로 돔으로써 evict_start의 유지 */
-	struct list_elem *temp = evict_start;
+		/* 바늘을 옮기기 전에 멈춰야 보지 않은 프레임이 이번 기회를 잃지 않음 */
+		if (dirty_cnt > 0 && ++dirty_scanned > CLEAN_SEARCH)
+			break;
 
-	for (temp; temp != list_end(&frame_table); temp = list_next(temp))
-	{
-		victim = list_entry(temp, struct frame, frame_elem);
+		frame = &frames[clock_hand];
+		clock_hand = (clock_hand + 1) % frame_cnt;
+		scanned++;
 
-		if (victim->page == NULL)
-		{
-			lock_release(&frame_table_lock);
-			return victim;
-		}
-		/* frame table의 entry page가 최근에 access 된 경우 = accessed bit(1) = true 반환 */
-		if (pml4_is_accessed(curr->pml4, victim->page->va))
-		{
-			/* set_accessed로 accessed bit를 1에서 0으로 설정한 후 넘어감 */
-			pml4_set_accessed(curr->pml4, victim->page->va, 0);
-		}
-		else
+		/* 비어 있거나, 고정된 프레임은 퇴거 대상에서 제외 */
+		if (frame->kva == NULL || !vm_frame_evictable(frame))
+			continue;
+
+		/* 프레임을 매핑한 페이지들의 (owner의) pml4에서 accessed bit 확인 후 0으로 */
+		if (vm_frame_test_accessed(frame))
+			continue;
+
+		if (!vm_frame_needs_write(frame))
 		{
-			/* 최근에 accessed 된 경우가 아니라면, accessed bit(0) = swap out될 대상이 됨 */
-			lock_release(&frame_table_lock);
-			evict_start = list_next(temp);
-			return victim;
+			clean = frame;
+			break;
 		}
+		if (dirty_cnt < max)
+			victims[dirty_cnt++] = frame;
 	}
 
-	for (temp = list_begin(&frame_table); temp != evict_start; temp = list_next(&frame_table))
+	if (clean != NULL)
 	{
-		victim = list_entry(temp, struct frame, frame_elem);
+		victims[0] = clean;
+		dirty_cnt = 0;
+	}
 
-		if (pml4_is_accessed(curr->pml4, victim->page->va))
-		{
-			/* set_accessed로 accessed bit를 1에서 0으로 설정한 후 넘어감 */
-			pml4_set_accessed(curr->pml4, victim->page->va, 0);
-		}
-		else
+	/* 실제로 퇴거할 프레임만 셈 */
+	evict_cnt += clean != NULL ? 1 : dirty_cnt;
+	evict_dirty_cnt += dirty_cnt;
+	evict_scan_cnt += scanned;
+	lock_release(&frame_table_lock);
+	return clean != NULL ? 1 : dirty_cnt;
+}
+
+/* NOTE: [Improve] FRAME을 퇴거하려면 디스크에 써야 하는지 확인 */
+/* anon 페이지는 항상 swap에 써야 하고, file 페이지는 (어느 sharer든) 수정된 경우에만 쓴다.
+   share table의 프레임은 읽기 전용이라 그냥 버리면 된다 */
+static bool
+vm_frame_needs_write(struct frame *frame)
+{
+	struct page *page = frame->page;
+	struct list_elem *e;
+
+	if (frame->inode != NULL)
+		return false;
+	if (VM_TYPE(page->operations->type) == VM_ANON)
+		return true;
+	if (list_empty(&frame->sharers))
+		return pml4_is_dirty(page->owner->pml4, page->va);
+
+	for (e = list_begin(&frame->sharers); e != list_end(&frame->sharers); e = list_next(e))
+	{
+		page = list_entry(e, struct page, sharer_elem);
+		if (pml4_is_dirty(page->owner->pml4, page->va))
+			return true;
+	}
+	return false;
+}
+
+/* NOTE: [Improve] 페이지가 매핑된 프레임은 고정되어 있지 않으면 퇴거할 수 있다.
+   여러 페이지가 공유하는 프레임(share table, fork)은 sharers로 모든 매핑을 알고 있으므로
+   모두 떼어내고 퇴거한다 */
+static bool
+vm_frame_evictable(struct frame *frame)
+{
+	return frame->page != NULL && frame->pin_cnt == 0;
+}
+
+/* NOTE: [Improve] FRAME을 매핑한 페이지 중 최근에 접근한 것이 있는지 확인하고
+   accessed bit를 모두 0으로 되돌린다. frame_table_lock을 잡은 채로 호출 */
+static bool
+vm_frame_test_accessed(struct frame *frame)
+{
+	struct list_elem *e;
+	struct page *page;
+	bool accessed = false;
+
+	if (list_empty(&frame->sharers))
+	{
+		page = frame->page;
+		accessed = pml4_is_accessed(page->owner->pml4, page->va);
+		if (accessed)
+			pml4_set_accessed(page->owner->pml4, page->va, 0);
+		return accessed;
+	}
+
+	for (e = list_begin(&frame->sharers); e != list_end(&frame->sharers); e = list_next(e))
+	{
+		page = list_entry(e, struct page, sharer_elem);
+		if (pml4_is_accessed(page->owner->pml4, page->va))
 		{
-			/* 최근에 accessed 된 경우가 아니라면, accessed bit(0) = swap out될 대상이 됨 */
-			lock_release(&frame_table_lock);
-			evict_start = list_next(temp);
-			return victim;
+			pml4_set_accessed(page->owner->pml4, page->va, 0);
+			accessed = true;
 		}
 	}
+	return accessed;
+}
 
+/* palloc() and get frame. If there is no available page, evict the page
+ * and return it. This always return valid address. That is, if the user pool
+ * memory is full, this function evicts the frame to get the available memory
+ * space.*/
+/* NOTE: [Improve] 퇴거할 수 있는 프레임이 하나도 없으면 (모두 고정됨) NULL을 반환하고,
+   호출한 쪽의 fault는 실패해서 그 프로세스가 종료된다 */
+static struct frame *
+vm_get_frame(void)
+{
+	struct frame *frame = NULL;
+	void *kva = palloc_get_page(PAL_USER);
+
+	/* user pool이 가득 찼다면 페이지 하나를 퇴거시키고 그 프레임을 재사용 */
+	if (kva == NULL)
+	{
+		frame = vm_evict_frame();
+		if (frame == NULL)
+			return NULL;
+		frame->page = NULL;
+		frame->ref_cnt = 1;
+		list_init(&frame->sharers);
+		ASSERT(frame->inode == NULL);
+		return frame;
+	}
+
+	frame = vm_frame_create(kva);
+	ASSERT(frame->page == NULL);
+	return frame;
+}
+
+/* NOTE: [Improve] 물리 페이지 KVA를 담는 frame을 frame table에서 꺼내 초기화 */
+static struct frame *
+vm_frame_create(void *kva)
+{
+	/* frame 구조체는 user pool 안에서의 위치로 frame 배열에서 찾음 */
+	struct frame *frame = &frames[palloc_user_page_idx(kva)];
+
+	lock_acquire(&frame_table_lock);
+	ASSERT(frame->kva == NULL);
+	frame->page = NULL;
+	frame->ref_cnt = 1;
+	frame->pin_cnt = 0;
+	frame->inode = NULL;
+	list_init(&frame->sharers);
+	frame->kva = kva;
 	lock_release(&frame_table_lock);
-	evict_start = list_next(evict_start);
-	return victim;
+	return frame;
+}
+
+/* NOTE: [Improve] 남는 프레임이 있을 때만 PAGE를 미리 올려 둔다 (readahead용) */
+/* 다른 페이지를 퇴거시키지 않으며, 올린 페이지는 accessed bit가 0이라 먼저 퇴거 대상이 된다 */
+bool vm_prefetch_page(struct page *page, bool map)
+{
+	struct inode *inode;
+	off_t ofs;
+	uint32_t read_bytes;
+	/* 읽기 전에 key를 얻어야 함 (uninit 페이지는 aux에 파일 정보가 있음) */
+	bool shareable = page_share_key(page, &inode, &ofs, &read_bytes);
+	void *kva = palloc_get_page(PAL_USER);
+	struct frame *frame;
+
+	if (kva == NULL)
+		return false;
+
+	frame = vm_frame_create(kva);
+	frame->page = page;
+	page->frame = frame;
+
+	/* NOTE: [Improve] MAP이 false면 읽어만 두고 매핑하지 않음 (접근하면 I/O 없는 폴트가 남) */
+	if ((map && !pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable)) || !swap_in(page, frame->kva))
+	{
+		vm_release_frame(page);
+		return false;
+	}
+
+	/* NOTE: [Improve] 미리 읽은 읽기 전용 파일 페이지도 다른 프로세스가 함께 쓰도록 */
+	if (shareable)
+		vm_share_insert(frame, inode, ofs, read_bytes);
+	return true;
+}
+
+/* NOTE: [Improve] PAGE의 내용이 이미 메모리(share table)에 있으면 디스크 I/O 없이 그 프레임을 매핑.
+   매핑했으면 true, 없으면 아무것도 하지 않고 false (fault-around용) */
+bool vm_map_cached_page(struct page *page)
+{
+	struct inode *inode;
+	off_t ofs;
+	uint32_t read_bytes;
+
+	return page_share_key(page, &inode, &ofs, &read_bytes) && vm_share_map(page, inode, ofs, read_bytes);
 }
 
 /* Growing the stack. */
@@ -263,9 +642,75 @@ vm_stack_growth(void *addr UNUSED)
 }
 
 /* Handle the fault on write_protected page */
+/* NOTE: [Improve] copy-on-write 페이지에 처음 쓰기를 한 경우 */
+/* 프레임을 나 혼자 쓰고 있다면 쓰기 권한만 되돌리고, 공유 중이라면 새 프레임에 복사 */
 static bool
-vm_handle_wp(struct page *page UNUSED)
+vm_handle_wp(struct page *page)
 {
+	struct thread *curr = thread_current();
+	struct frame *old = page->frame;
+	struct frame *new;
+
+	/* 원래 읽기 전용인 페이지에 쓴 것이라면 진짜 권한 위반 */
+	if (old == NULL || !page->writable)
+		return false;
+
+	lock_acquire(&frame_table_lock);
+	if (old->ref_cnt == 1)
+	{
+		/* 다른 프로세스가 먼저 복사해 갔거나 종료해서 이제 나만 남은 경우 */
+		old->page = page;
+		list_init(&old->sharers);
+		lock_release(&frame_table_lock);
+		pml4_set_writable(curr->pml4, page->va, true);
+		return true;
+	}
+
+	/* NOTE: [Improve] 새 프레임을 받는 동안 (퇴거 때문에 잠들 수 있음) 다른 sharer가
+	   종료해도 old가 해제되거나 퇴거되지 않도록 참조를 하나 더 잡고 고정해 둔다 */
+	old->ref_cnt++;
+	old->pin_cnt++;
+	lock_release(&frame_table_lock);
+
+	new = vm_get_frame();
+
+	lock_acquire(&frame_table_lock);
+	old->pin_cnt--;
+	old->ref_cnt--;
+	if (new == NULL)
+	{
+		lock_release(&frame_table_lock);
+		return false;
+	}
+	if (old->ref_cnt == 1)
+	{
+		/* 기다리는 동안 나만 남았다면 복사하지 않고 old를 그대로 씀 */
+		old->page = page;
+		list_init(&old->sharers);
+		lock_release(&frame_table_lock);
+		vm_frame_unref(new);
+		pml4_set_writable(curr->pml4, page->va, true);
+		return true;
+	}
+	lock_release(&frame_table_lock);
+
+	memcpy(new->kva, old->kva, PGSIZE);
+	new->page = page;
+	page->frame = new;
+
+	/* NOTE: [Improve] sharers에서 빠지고, 대표 페이지였다면 남은 sharer에게 넘김 */
+	lock_acquire(&frame_table_lock);
+	list_remove(&page->sharer_elem);
+	if (old->page == page)
+		old->page = !list_empty(&old->sharers)
+						? list_entry(list_front(&old->sharers), struct page, sharer_elem)
+						: NULL;
+	lock_release(&frame_table_lock);
+	vm_frame_unref(old);
+
+	/* 읽기 전용 매핑을 지우고 (TLB도 비움) 새 프레임을 쓰기 가능으로 매핑 */
+	pml4_clear_page(curr->pml4, page->va);
+	return pml4_set_page(curr->pml4, page->va, new->kva, true);
 }
 
 /* Return true on success */
@@ -308,14 +753,40 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 		page = spt_find_page(spt, addr);
 		if (page == NULL)
 		{
-			return false;
+			/* NOTE: [Improve] 아직 페이지가 없다면 mmap/ELF 범위(VMA)에서 지금 만든다 */
+			return vma_fault(spt, addr, write);
 		}
 		/* 쓰기가 불가능한 페이지(0)에 write를 요청한 경우 */
 		if (write == 1 && page->writable == 0)
 		{
 			return false;
 		}
-		return vm_do_claim_page(page);
+
+		/* NOTE: [Improve] readahead가 읽어만 두고 매핑하지 않은 페이지 = async 표시 */
+		/* copy-on-write 프레임(퇴거 중에 매핑이 지워진 경우)은 계속 읽기 전용으로 */
+		if (page->frame != NULL)
+		{
+			bool writable = page->writable &&
+							(VM_TYPE(page->operations->type) != VM_ANON || page->frame->ref_cnt == 1);
+
+			if (!pml4_set_page(thread_current()->pml4, page->va, page->frame->kva, writable))
+				return false;
+			vma_readahead(spt, page->va, true);
+			return true;
+		}
+
+		/* NOTE: [Improve] 퇴거된 파일 페이지를 다시 읽을 때도 readahead */
+		if (!vm_do_claim_page(page))
+			return false;
+		vma_readahead(spt, page->va, false);
+		return true;
+	}
+
+	/* NOTE: [Improve] 매핑은 있지만 읽기 전용인 페이지에 쓴 경우 = copy-on-write */
+	if (write)
+	{
+		page = spt_find_page(spt, addr);
+		return page != NULL && vm_handle_wp(page);
 	}
 	return false;
 }
@@ -325,7 +796,75 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 void vm_dealloc_page(struct page *page)
 {
 	destroy(page);
-	free(page);
+	kmem_cache_free(page_struct_cache, page);
+}
+
+/* NOTE: [Improve] PAGE의 매핑을 지우고 프레임 참조를 하나 내려놓는다 */
+/* 마지막 참조였다면 프레임을 frame table에서 빼고 물리 페이지까지 반환한다.
+   그래서 pml4_destroy()는 VM이 관리하는 프레임을 다시 해제하지 않는다 */
+void vm_release_frame(struct page *page)
+{
+	struct frame *frame = page->frame;
+
+	if (frame == NULL)
+		return;
+
+	pml4_clear_page(thread_current()->pml4, page->va);
+	page->frame = NULL;
+
+	lock_acquire(&frame_table_lock);
+	/* NOTE: [Improve] 공유 프레임(share table, copy-on-write)이라면 sharers에서 빼고
+	   남은 sharer를 대표 페이지로 */
+	if (frame->inode != NULL || !list_empty(&frame->sharers))
+		list_remove(&page->sharer_elem);
+	if (frame->page == page)
+		frame->page = !list_empty(&frame->sharers)
+						  ? list_entry(list_front(&frame->sharers), struct page, sharer_elem)
+						  : NULL;
+	lock_release(&frame_table_lock);
+	vm_frame_unref(frame);
+}
+
+/* NOTE: [Improve] FRAME의 참조 수를 줄이고, 0이 되면 해제 */
+static void
+vm_frame_unref(struct frame *frame)
+{
+	struct inode *inode = frame->inode;
+	void *kva = frame->kva;
+
+	lock_acquire(&frame_table_lock);
+	if (--frame->ref_cnt > 0)
+	{
+		lock_release(&frame_table_lock);
+		return;
+	}
+
+	/* share table에 등록된 프레임이었다면 테이블에서도 뺌 */
+	if (inode != NULL)
+		hash_delete(&share_table, &frame->share_elem);
+
+	/* frame 배열의 칸을 비움 */
+	frame->kva = NULL;
+	frame->page = NULL;
+	frame->inode = NULL;
+	lock_release(&frame_table_lock);
+
+	inode_close(inode);
+	palloc_free_page(kva);
+}
+
+/* NOTE: [Improve] fork에서 PAGE가 FRAME을 함께 매핑: 참조 수를 올리고 sharers에 등록 */
+/* copy-on-write 프레임은 처음 공유될 때 원래 페이지도 sharers에 넣어서,
+   어느 페이지가 먼저 떠나도 남은 페이지를 대표(frame->page)로 삼을 수 있게 한다 */
+static void
+vm_frame_add_sharer(struct frame *frame, struct page *page)
+{
+	lock_acquire(&frame_table_lock);
+	if (frame->inode == NULL && list_empty(&frame->sharers))
+		list_push_back(&frame->sharers, &frame->page->sharer_elem);
+	list_push_back(&frame->sharers, &page->sharer_elem);
+	frame->ref_cnt++;
+	lock_release(&frame_table_lock);
 }
 
 /* Claim the page that allocate on VA. */
@@ -348,8 +887,19 @@ bool vm_claim_page(void *va UNUSED)
 static bool
 vm_do_claim_page(struct page *page)
 {
+	struct inode *inode;
+	off_t ofs;
+	uint32_t read_bytes;
+	bool shareable = page_share_key(page, &inode, &ofs, &read_bytes);
+
+	/* NOTE: [Improve] 같은 파일 조각을 다른 페이지가 이미 읽어 두었다면 그 프레임을 함께 매핑 */
+	if (shareable && vm_share_map(page, inode, ofs, read_bytes))
+		return true;
+
 	/* 프레임 할당 받음 */
 	struct frame *frame = vm_get_frame();
+	if (frame == NULL)
+		return false;
 
 	/* Set links, 페이지와 프레임 매핑 */
 	frame->page = page;
@@ -358,14 +908,227 @@ vm_do_claim_page(struct page *page)
 	/* 가상주소와 물리주소를 매핑한 정보를 페이지 테이블에 추가 */
 	struct thread *curr = thread_current();
 	pml4_set_page(curr->pml4, page->va, frame->kva, page->writable);
-	return swap_in(page, frame->kva);
+	if (!swap_in(page, frame->kva))
+		return false;
+
+	/* NOTE: [Improve] 다음 프로세스가 함께 쓸 수 있도록 share table에 등록 */
+	if (shareable)
+		vm_share_insert(frame, inode, ofs, read_bytes);
+	return true;
+}
+
+/* NOTE: [Improve] PAGE가 share table로 공유할 수 있는 페이지인지 확인 */
+/* 읽기 전용 file-backed 페이지(실행 파일의 text, 읽기 전용 mmap)만 공유한다.
+   공유할 수 있다면 파일의 (inode, ofs)와 읽을 바이트 수를 채워 true 반환 */
+static bool
+page_share_key(struct page *page, struct inode **inode, off_t *ofs, uint32_t *read_bytes)
+{
+	struct file *file;
+
+	if (page->writable || page_get_type(page) != VM_FILE)
+		return false;
+
+	/* 아직 한 번도 읽지 않은 페이지라면 파일 정보는 uninit의 aux에 있다 */
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+	{
+		struct lazy_load_arg *arg = page->uninit.aux;
+		file = arg->file;
+		*ofs = arg->ofs;
+		*read_bytes = arg->read_bytes;
+	}
+	else
+	{
+		file = page->file.file;
+		*ofs = page->file.ofs;
+		*read_bytes = page->file.read_bytes;
+	}
+
+	if (file == NULL)
+		return false;
+	*inode = file_get_inode(file);
+	return true;
+}
+
+/* NOTE: [Improve] share table에서 (INODE, OFS) 프레임을 찾아 PAGE에 읽기 전용으로 매핑 */
+/* 찾지 못했다면 false를 반환하고, 호출한 쪽에서 새 프레임에 파일을 읽는다 */
+static bool
+vm_share_map(struct page *page, struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+	struct frame *frame;
+
+	lock_acquire(&frame_table_lock);
+	frame = share_find(inode, ofs);
+
+	/* 같은 위치라도 읽은 길이가 다르면 (파일 끝 부분) 내용이 다를 수 있음 */
+	if (frame == NULL || frame->read_bytes != read_bytes)
+	{
+		lock_release(&frame_table_lock);
+		return false;
+	}
+
+	frame->ref_cnt++;
+	list_push_back(&frame->sharers, &page->sharer_elem);
+	page->frame = frame;
+	lock_release(&frame_table_lock);
+
+	/* uninit 페이지라면 파일을 다시 읽지 않고 file page로 초기화만 한다 */
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		page->uninit.page_initializer(page, page->uninit.type, frame->kva);
+
+	return pml4_set_page(thread_current()->pml4, page->va, frame->kva, false);
+}
+
+/* NOTE: [Improve] 파일을 막 읽어 온 FRAME을 (INODE, OFS)로 share table에 등록 */
+/* 다른 프로세스가 같은 조각을 먼저 등록했다면 이 프레임은 공유하지 않고 그대로 둔다 */
+static void
+vm_share_insert(struct frame *frame, struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+	/* 프레임이 share table에 있는 동안 inode가 해제되어 주소가 재사용되지 않도록 */
+	inode_reopen(inode);
+
+	lock_acquire(&frame_table_lock);
+	frame->inode = inode;
+	frame->ofs = ofs;
+	frame->read_bytes = read_bytes;
+	if (hash_insert(&share_table, &frame->share_elem) != NULL)
+	{
+		frame->inode = NULL;
+		lock_release(&frame_table_lock);
+		inode_close(inode);
+		return;
+	}
+	list_push_back(&frame->sharers, &frame->page->sharer_elem);
+	lock_release(&frame_table_lock);
+}
+
+/* NOTE: [Improve] 공유 프레임 FRAME을 퇴거: 모든 sharer의 매핑을 지우고 share table에서 뺌 */
+/* 읽기 전용 페이지라 디스크에 다시 쓸 필요는 없고, 다음 접근 때 파일에서 다시 읽는다 */
+static void
+vm_share_evict(struct frame *frame)
+{
+	struct inode *inode;
+
+	lock_acquire(&frame_table_lock);
+	inode = vm_share_drop(frame);
+	lock_release(&frame_table_lock);
+
+	inode_close(inode);
+}
+
+/* NOTE: [Improve] fork로 공유 중인 쓰기 가능한 파일 프레임 FRAME을 퇴거 */
+/* 어느 sharer든 수정했다면 파일에 한 번 쓰고, 모든 sharer를 떼어내 다음 접근 때 파일에서
+   다시 읽게 한다. 쓰는 동안 다시 매핑되어 수정되었다면 한 번 더 쓴다.
+   쓰는 동안 sharer가 종료해도 프레임이 해제되지 않도록 참조를 하나 잡아 둔다 */
+static void
+vm_file_evict_shared(struct frame *frame)
+{
+	struct inode *inode = NULL;
+	struct list_elem *e;
+	struct page *page;
+	off_t ofs = 0;
+	uint32_t read_bytes = 0;
+	bool dirty;
+
+	lock_acquire(&frame_table_lock);
+	frame->ref_cnt++;
+	for (;;)
+	{
+		dirty = false;
+		for (e = list_begin(&frame->sharers); e != list_end(&frame->sharers); e = list_next(e))
+		{
+			page = list_entry(e, struct page, sharer_elem);
+			if (pml4_is_dirty(page->owner->pml4, page->va))
+				dirty = true;
+			pml4_clear_page(page->owner->pml4, page->va);
+		}
+		if (!dirty)
+			break;
+
+		/* 쓰는 동안 페이지들이 해제되어 파일이 닫혀도 쓸 수 있도록 inode를 잡아 둠 */
+		if (inode == NULL)
+		{
+			inode = inode_reopen(file_get_inode(frame->page->file.file));
+			ofs = frame->page->file.ofs;
+			read_bytes = frame->page->file.read_bytes;
+		}
+		lock_release(&frame_table_lock);
+		inode_write_at(inode, frame->kva, read_bytes, ofs);
+		lock_acquire(&frame_table_lock);
+	}
+
+	while (!list_empty(&frame->sharers))
+	{
+		page = list_entry(list_pop_front(&frame->sharers), struct page, sharer_elem);
+		page->frame = NULL;
+	}
+	frame->page = NULL;
+	frame->ref_cnt = 1;
+	lock_release(&frame_table_lock);
+
+	inode_close(inode);
+}
+
+/* NOTE: [Improve] frame_table_lock을 잡은 채로 공유 프레임 FRAME의 매핑을 모두 지우고
+   share table에서 뺀다. FRAME은 참조 1개짜리 빈 프레임이 되고, 닫아야 할 inode를 반환 */
+static struct inode *
+vm_share_drop(struct frame *frame)
+{
+	struct inode *inode;
+	struct page *page;
+
+	while (!list_empty(&frame->sharers))
+	{
+		page = list_entry(list_pop_front(&frame->sharers), struct page, sharer_elem);
+		pml4_clear_page(page->owner->pml4, page->va);
+		page->frame = NULL;
+	}
+	hash_delete(&share_table, &frame->share_elem);
+	inode = frame->inode;
+	frame->inode = NULL;
+	frame->page = NULL;
+	frame->ref_cnt = 1;
+	return inode;
+}
+
+/* NOTE: [Improve] INODE의 [OFS, OFS + SIZE) 범위가 write()로 바뀌었을 때 inode_write_at()이 호출 */
+/* 그 범위를 담은 공유 프레임은 내용이 낡았으므로 모든 매핑을 지우고 해제한다.
+   이 페이지들은 다음 접근 때 파일에서 새 내용을 읽는다 (share table의 ofs는 페이지 정렬) */
+void vm_share_invalidate(struct inode *inode, off_t ofs, off_t size)
+{
+	off_t pos;
+
+	if (size <= 0 || hash_empty(&share_table))
+		return;
+
+	for (pos = ROUND_DOWN(ofs, PGSIZE); pos < ofs + size; pos += PGSIZE)
+	{
+		struct frame *frame;
+		struct inode *closed = NULL;
+
+		lock_acquire(&frame_table_lock);
+		frame = share_find(inode, pos);
+		if (frame != NULL)
+			closed = vm_share_drop(frame);
+		lock_release(&frame_table_lock);
+
+		if (frame != NULL)
+		{
+			inode_close(closed);
+			vm_frame_unref(frame);
+		}
+	}
 }
 
 /* Initialize new supplemental page table */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 {
 	/* spt 초기화 */
-	hash_init(&spt->spt_hash, hash_func, less_func, NULL);
+	/* NOTE: [Improve] 최상위 노드는 첫 페이지를 넣을 때 만든다 */
+	spt->root = NULL;
+	spt->page_cnt = 0;
+	list_init(&spt->vmas);
+	spt->vma_hint = NULL;
+	spt->owner = thread_current();
 }
 
 /* Copy supplemental page table from src to dst */
@@ -374,66 +1137,107 @@ void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 								  struct supplemental_page_table *src UNUSED)
 {
-	struct hash_iterator i;
-	hash_first(&i, &src->spt_hash);
-	/* src 각각의 페이지들을 반복문으로 복사 */
-	while (hash_next(&i))
+	struct spt_copy_aux copy = {dst, src};
+
+	/* NOTE: [Improve] 범위(VMA)를 먼저 복사해서 자식의 파일 페이지가 자식의 파일 핸들을 쓰도록 */
+	if (!vma_copy(dst, src))
+		return false;
+
+	/* NOTE: [Improve] src 각각의 페이지들을 va 순서대로 복사 */
+	return spt_for_each(src, NULL, SPT_END, spt_copy_page, &copy);
+}
+
+/* NOTE: [Improve] supplemental_page_table_copy()에서 페이지 하나를 복사 */
+static bool
+spt_copy_page(struct page *src_page, void *aux)
+{
+	struct spt_copy_aux *copy = aux;
+
+	/* 현재 src_page의 속성들 */
+	enum vm_type type = src_page->operations->type;
+	void *upage = src_page->va;
+	bool writable = src_page->writable;
+
+	/* page가 uninit type이라면  */
+	if (type == VM_UNINIT)
 	{
-		/* 현재 src_page의 속성들 */
-		struct page *src_page = hash_entry(hash_cur(&i), struct page, bucket_elem);
-		enum vm_type type = src_page->operations->type;
-		void *upage = src_page->va;
-		bool writable = src_page->writable;
+		/* uninit type의 페이지 생성 및 초기화 */
+		vm_initializer *init = src_page->uninit.init;
+		void *init_aux = src_page->uninit.aux;
+		/* NOTE: [Improve] 원래 타입 그대로 (읽기 전용 text는 VM_FILE) */
+		vm_alloc_page_with_initializer(src_page->uninit.type, upage, writable, init, init_aux);
+		return true;
+	}
 
-		/* page가 uninit type이라면  */
-		if (type == VM_UNINIT)
+	/* page가 file_backed type이라면  */
+	if (type == VM_FILE)
+	{
+		/* NOTE: [Improve] file_backed_initializer()가 바로 읽어 가므로 스택에 둠 */
+		struct vma *vma = vma_find(copy->dst, upage);
+		struct lazy_load_arg file_aux;
+		file_aux.file = vma != NULL ? vma->file : src_page->file.file;
+		file_aux.ofs = src_page->file.ofs;
+		file_aux.read_bytes = src_page->file.read_bytes;
+		file_aux.zero_bytes = src_page->file.zero_bytes;
+
+		if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, &file_aux))
 		{
-			/* uninit type의 페이지 생성 및 초기화 */
-			vm_initializer *init = src_page->uninit.init;
-			void *aux = src_page->uninit.aux;
-			vm_alloc_page_with_initializer(VM_ANON, upage, writable, init, aux);
-			continue;
+			return false;
 		}
 
-		/* page가 file_backed type이라면  */
-		if (type == VM_FILE)
-		{
-			struct lazy_load_arg *file_aux = malloc(sizeof(struct lazy_load_arg));
-			file_aux->file = src_page->file.file;
-			file_aux->ofs = src_page->file.ofs;
-			file_aux->read_bytes = src_page->file.read_bytes;
-			file_aux->zero_bytes = src_page->file.zero_bytes;
+		struct page *file_page = spt_find_page(copy->dst, upage);
+		file_backed_initializer(file_page, type, NULL);
 
-			if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, file_aux))
-			{
-				return false;
-			}
+		/* 퇴거된 페이지라면 다음 접근 때 파일에서 읽음 */
+		if (src_page->frame == NULL)
+			return true;
+		file_page->frame = src_page->frame;
 
-			struct page *file_page = spt_find_page(dst, upage);
-			file_backed_initializer(file_page, type, NULL);
-			file_page->frame = src_page->frame;
+		/* NOTE: [Improve] 공유하는 프레임의 참조 수 증가, sharer로 등록 */
+		vm_frame_add_sharer(src_page->frame, file_page);
 
-			pml4_set_page(thread_current()->pml4, file_page->va, src_page->frame->kva, src_page->writable);
-			continue;
-		}
+		pml4_set_page(thread_current()->pml4, file_page->va, src_page->frame->kva, src_page->writable);
+		return true;
+	}
 
-		/* page가 anon type이라면 */
-		if (!vm_alloc_page(type, upage, writable))
+	/* page가 anon type이라면 */
+	if (!vm_alloc_page(type, upage, writable))
+	{
+		return false;
+	}
+
+	/* NOTE: [Improve] Copy-on-write */
+	/* 프레임이 있는 anon 페이지는 바로 복사하지 않고 부모의 프레임을 읽기 전용으로
+	   부모와 자식 모두에 매핑한다. 실제 복사는 처음 쓰기를 할 때 vm_handle_wp()에서 */
+	if (src_page->frame != NULL)
+	{
+		struct frame *frame = src_page->frame;
+		struct page *cow_page = spt_find_page(copy->dst, upage);
+
+		anon_initializer(cow_page, type, NULL);
+		cow_page->frame = frame;
+		vm_frame_add_sharer(frame, cow_page);
+
+		if (!pml4_set_page(thread_current()->pml4, upage, frame->kva, false))
 		{
 			return false;
 		}
-
-		/* 부모 type의 초기화 함수를 담은 uninit page로 초기화 후 */
-		/* page fault 처리 (vm_claim_page) 후 memcpy */
-		if (!vm_claim_page(upage))
+		if (writable)
 		{
-			return false;
+			pml4_set_writable(copy->src->owner->pml4, upage, false);
 		}
+		return true;
+	}
 
-		struct page *dst_page = spt_find_page(dst, upage);
-		memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+	/* NOTE: [Improve] 프레임이 없는 anon 페이지 = swap 된 페이지 */
+	/* 자식 페이지에 프레임을 받은 뒤, 부모의 slot은 그대로 두고 그 내용을 읽어 옴 */
+	if (!vm_claim_page(upage))
+	{
+		return false;
 	}
-	return true;
+
+	struct page *dst_page = spt_find_page(copy->dst, upage);
+	return anon_read_slot(src_page, dst_page->frame->kva);
 }
 
 /* Free the resource hold by the supplemental page table */
@@ -444,31 +1248,73 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED)
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
 
-	hash_clear(&spt->spt_hash, hash_page_destroy);
+	/* NOTE: [Improve] mmap/ELF 범위는 VMA 단위로 해제하고 (파일도 닫음),
+	   남은 페이지(스택)와 노드는 트리를 한 번 훑으며 해제 */
+	vma_kill(spt);
+	spt_remove_range(spt, NULL, SPT_END);
+	palloc_free_page(spt->root);
+	spt->root = NULL;
 }
 
-/* --------- 추가 함수 --------- */
-uint64_t hash_func(const struct hash_elem *e, void *aux)
+/* NOTE: [Improve] share table: (inode, ofs)를 key로 해싱 */
+static uint64_t
+share_hash(const struct hash_elem *e, void *aux UNUSED)
 {
-	/* 해싱하는 함수 */
-	/* hash_elem으로 page 가져오기 */
-	const struct page *page_ = hash_entry(e, struct page, bucket_elem);
-	/* page의 va(가상주소)를 key값으로 해 해싱한 후 bucket_idx 값 반환 */
-	return hash_bytes(&page_->va, sizeof(page_->va));
+	const struct frame *frame = hash_entry(e, struct frame, share_elem);
+	struct share_key key = {frame->inode, frame->ofs};
+
+	return share_key_hash(&key);
 }
 
-bool less_func(const struct hash_elem *a, const struct hash_elem *b, void *aux)
+static bool
+share_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
 {
-	/* hash_elem으로 가져온 두 페이지의 가상주소를 기준으로 비교하는 함수 */
-	const struct page *a_page = hash_entry(a, struct page, bucket_elem);
-	const struct page *b_page = hash_entry(b, struct page, bucket_elem);
+	const struct frame *a_frame = hash_entry(a, struct frame, share_elem);
+	const struct frame *b_frame = hash_entry(b, struct frame, share_elem);
 
-	return a_page->va < b_page->va;
+	if (a_frame->inode != b_frame->inode)
+		return a_frame->inode < b_frame->inode;
+	return a_frame->ofs < b_frame->ofs;
 }
 
-void hash_page_destroy(struct hash_elem *e, void *aux)
+static uint64_t
+share_key_hash(const struct share_key *key)
 {
-	struct page *page = hash_entry(e, struct page, bucket_elem);
-	destroy(page);
-	free(page);
-}
\ No newline at end of file
+	return hash_bytes(&key->inode, sizeof key->inode) ^ hash_int(key->ofs);
+}
+
+static bool
+share_match(const struct hash_elem *e, const void *key_, void *aux UNUSED)
+{
+	const struct frame *frame = hash_entry(e, struct frame, share_elem);
+	const struct share_key *key = key_;
+
+	return frame->inode == key->inode && frame->ofs == key->ofs;
+}
+
+/* NOTE: [Improve] share table에서 (INODE, OFS) 프레임을 찾음. frame_table_lock을 잡고 호출 */
+static struct frame *
+share_find(struct inode *inode, off_t ofs)
+{
+	struct share_key key = {inode, ofs};
+	struct hash_elem *e;
+
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+
+	e = hash_find_key(&share_table, share_key_hash(&key), share_match, &key);
+	return e != NULL ? hash_entry(e, struct frame, share_elem) : NULL;
+}
+
+/* NOTE: [Improve] frame table / 퇴거 통계 출력 */
+void vm_print_stats(void)
+{
+	int64_t ticks = timer_ticks();
+
+	printf("Frames: %zu frames, %lld evictions (%lld dirty), %lld frames scanned per eviction, "
+		   "%lld evictions per second\n",
+		   frame_cnt, evict_cnt, evict_dirty_cnt,
+		   evict_cnt ? evict_scan_cnt / evict_cnt : 0,
+		   ticks ? evict_cnt * TIMER_FREQ / ticks : 0);
+	vma_print_stats();
+	vm_anon_print_stats();
+}
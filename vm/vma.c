@@ -0,0 +1,351 @@
+/* vma.c: Per-process virtual memory areas (mmap, ELF segments). */
+
+#include "vm/vma.h"
+#include "vm/vm.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include "include/userprog/process.h"
+#include <round.h>
+#include <stdio.h>
+
+/* NOTE: [Improve] VMA.
+   예전에는 mmap과 load_segment가 범위 안의 모든 페이지마다 struct page와
+   lazy_load_arg를 미리 만들어 spt에 넣었다 (100MB mmap이면 약 2만 5천 개).
+   이제는 범위마다 struct vma 하나만 만들고, 페이지 폴트가 나면 vma_fault()가
+   그 페이지의 파일 위치를 계산해 struct page 하나를 만들어 바로 claim 한다.
+   lazy_load_arg는 claim 하는 동안만 쓰이므로 스택에 둔다.
+
+   한 프로세스의 VMA는 ELF 세그먼트 몇 개와 mmap 몇 개뿐이라 start 순서로 정렬한
+   리스트로 두고, 연달아 같은 범위에서 폴트가 나는 경우를 위해 마지막으로 찾은
+   VMA(vma_hint)를 먼저 본다. VMA 리스트는 주인 스레드만 읽고 바꾸므로 따로 잠그지 않는다 */
+
+/* NOTE: [Improve] Fault-around.
+   파일 페이지에서 폴트가 나면 그 페이지가 속한 fault_around_pages 크기로 정렬된 창 안의
+   이웃 페이지 중 내용이 이미 메모리(share table)에 있는 페이지를 I/O 없이 함께 매핑한다(hit).
+   메모리에 없는 이웃(miss)을 읽을지는 아래 readahead가 접근 패턴을 보고 정한다.
+   커널 옵션 -fa=N으로 창 크기를 바꿀 수 있고, 1이면 끈다 */
+unsigned fault_around_pages = 16;
+
+/* NOTE: [Improve] Adaptive readahead.
+   VMA마다 마지막 폴트 페이지(ra_prev), 현재 창 크기(ra_window), async 창(ra_async)을 둔다.
+   - 순차 폴트 (바로 다음 페이지이거나 지난 창 바로 뒤): 창을 두 배로 (RA_INIT부터 RA_MAX까지)
+     키우고 폴트 페이지 뒤의 창을 남는 프레임에 미리 읽는다.
+   - 랜덤 폴트: 창을 절반으로 줄이고 아무것도 읽지 않는다.
+   창의 끝에서 ra_async 페이지 앞의 한 페이지(async 표시)는 읽어만 두고 매핑하지 않는다.
+   프로세스가 거기에 닿으면 I/O 없는 폴트가 나고, 그때 지금 창이 다 끝나기 전에 다음 창을 읽는다.
+   미리 읽은 페이지는 dirty/accessed bit가 0이라, 쓰지 않으면 CLOCK이 먼저 퇴거시킨다.
+   디스크 I/O는 동기식이라 "async"는 창이 끝나기 전에 미리 읽는다는 뜻이다 */
+#define RA_INIT 4  /* 처음 순차로 판단했을 때의 창 크기 (페이지) */
+#define RA_MAX 64  /* 최대 창 크기 (페이지) */
+
+/* 통계 */
+static long long fault_around_cnt;	/* fault-around를 한 폴트 수 */
+static long long fault_around_hit;	/* 메모리에 있던 것을 매핑한 이웃 페이지 수 */
+static long long fault_around_miss; /* 메모리에 없던 이웃 페이지 수 */
+static long long ra_sync_cnt;		/* 순차 폴트로 읽은 창 수 */
+static long long ra_async_cnt;		/* async 표시 페이지에서 읽은 창 수 */
+static long long ra_random_cnt;		/* 랜덤으로 판단한 폴트 수 */
+static long long ra_page_cnt;		/* 미리 읽은 페이지 수 */
+
+static struct page *vma_new_page(struct supplemental_page_table *spt, struct vma *vma,
+								 void *upage, struct lazy_load_arg *arg);
+static void vma_fault_around(struct supplemental_page_table *spt, struct vma *vma, void *upage);
+
+/* [START, END)에 ADDR이 들어가는지 */
+static inline bool
+vma_contains(const struct vma *vma, const void *addr)
+{
+	return vma->start <= addr && addr < vma->end;
+}
+
+/* NOTE: [Improve] ADDR을 포함하는 VMA를 찾음, 없으면 NULL */
+struct vma *
+vma_find(struct supplemental_page_table *spt, const void *addr)
+{
+	struct list_elem *e;
+
+	if (spt->vma_hint != NULL && vma_contains(spt->vma_hint, addr))
+		return spt->vma_hint;
+
+	for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		/* start 순서로 정렬되어 있으므로 지나치면 없는 것 */
+		if (addr < vma->start)
+			break;
+		if (addr < vma->end)
+		{
+			spt->vma_hint = vma;
+			return vma;
+		}
+	}
+	return NULL;
+}
+
+/* NOTE: [Improve] [START, END)와 겹치는 VMA가 있으면 true */
+bool vma_overlaps(struct supplemental_page_table *spt, void *start, void *end)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (end <= vma->start)
+			break;
+		if (start < vma->end)
+			return true;
+	}
+	return false;
+}
+
+static bool
+vma_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	return list_entry(a, struct vma, elem)->start < list_entry(b, struct vma, elem)->start;
+}
+
+/* NOTE: [Improve] START부터 LENGTH 바이트(페이지 단위로 올림)를 VMA 하나로 등록.
+   FILE의 OFS부터 READ_BYTES 바이트를 읽고 나머지는 0으로 채우는 범위이며,
+   폴트가 나면 TYPE 타입의 페이지를 만든다. VMA는 FILE을 따로 다시 열어 들고 있다가
+   범위가 해제될 때 닫는다. 다른 VMA와 겹치거나 메모리가 없으면 false */
+bool vma_map(struct supplemental_page_table *spt, void *start, size_t length,
+			 struct file *file, off_t ofs, uint32_t read_bytes,
+			 enum vm_type type, bool writable, bool mmap)
+{
+	void *end = start + ROUND_UP(length, PGSIZE);
+	struct vma *vma;
+
+	ASSERT(pg_ofs(start) == 0);
+	ASSERT(ofs % PGSIZE == 0);
+
+	if (end <= start || !is_user_vaddr(end - 1) || vma_overlaps(spt, start, end))
+		return false;
+
+	vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return false;
+	vma->file = file_reopen(file);
+	if (vma->file == NULL)
+	{
+		free(vma);
+		return false;
+	}
+
+	vma->start = start;
+	vma->end = end;
+	vma->ofs = ofs;
+	vma->read_bytes = read_bytes;
+	vma->type = type;
+	vma->writable = writable;
+	vma->mmap = mmap;
+	vma->ra_prev = (size_t)-1;
+	vma->ra_next = 0;
+	vma->ra_window = 0;
+	vma->ra_async = 0;
+	list_insert_ordered(&spt->vmas, &vma->elem, vma_less, NULL);
+	return true;
+}
+
+/* NOTE: [Improve] ADDR에서 난 페이지 폴트를 VMA로 처리.
+   ADDR이 속한 페이지 하나만 만들어 claim 한다. VMA가 없거나, 읽기 전용 범위에
+   쓰려 했거나, 읽어 오지 못하면 false */
+bool vma_fault(struct supplemental_page_table *spt, void *addr, bool write)
+{
+	struct vma *vma = vma_find(spt, addr);
+	struct lazy_load_arg arg;
+	struct page *page;
+	void *upage = pg_round_down(addr);
+
+	if (vma == NULL || (write && !vma->writable))
+		return false;
+
+	page = vma_new_page(spt, vma, upage, &arg);
+	if (page == NULL)
+		return false;
+
+	/* claim이 끝나면 페이지는 anon/file 페이지가 되어 arg를 더 이상 보지 않는다 */
+	if (!vm_claim_page(upage))
+	{
+		spt_remove_page(spt, page);
+		return false;
+	}
+
+	vma_readahead(spt, upage, false);
+	return true;
+}
+
+/* NOTE: [Improve] VMA 안의 UPAGE에 uninit 페이지를 만들어 spt에 넣음.
+   페이지가 읽을 파일 위치와 길이는 ARG에 채우며, ARG는 claim이 끝날 때까지 살아 있어야 함 */
+static struct page *
+vma_new_page(struct supplemental_page_table *spt, struct vma *vma, void *upage,
+			 struct lazy_load_arg *arg)
+{
+	size_t pos = upage - vma->start;
+
+	arg->file = vma->file;
+	arg->ofs = vma->ofs + pos;
+	arg->read_bytes = pos < vma->read_bytes ? vma->read_bytes - pos : 0;
+	if (arg->read_bytes > PGSIZE)
+		arg->read_bytes = PGSIZE;
+	arg->zero_bytes = PGSIZE - arg->read_bytes;
+
+	if (!vm_alloc_page_with_initializer(vma->type, upage, vma->writable,
+										lazy_load_segment, arg))
+		return NULL;
+	return spt_find_page(spt, upage);
+}
+
+/* NOTE: [Improve] UPAGE에서 폴트가 난 뒤 같은 창 안의 이웃 페이지를 매핑 */
+static void
+vma_fault_around(struct supplemental_page_table *spt, struct vma *vma, void *upage)
+{
+	size_t window = (size_t)fault_around_pages * PGSIZE;
+	void *start = upage - (uint64_t)upage % window;
+	void *end = start + window;
+
+	if (start < vma->start)
+		start = vma->start;
+	if (end > vma->end)
+		end = vma->end;
+
+	fault_around_cnt++;
+	for (void *va = start; va < end; va += PGSIZE)
+	{
+		struct lazy_load_arg arg;
+		struct page *page;
+
+		if (va == upage || spt_find_page(spt, va) != NULL)
+			continue;
+
+		page = vma_new_page(spt, vma, va, &arg);
+		if (page == NULL)
+			break;
+		if (vm_map_cached_page(page))
+			fault_around_hit++;
+		else
+		{
+			/* 읽는 것은 readahead에 맡기고 페이지는 다시 빼 둔다 */
+			fault_around_miss++;
+			spt_remove_page(spt, page);
+		}
+	}
+}
+
+static size_t
+ra_grow(size_t window)
+{
+	if (window < RA_INIT)
+		return RA_INIT;
+	return window * 2 < RA_MAX ? window * 2 : RA_MAX;
+}
+
+/* NOTE: [Improve] VMA 안 UPAGE에서 폴트가 난 뒤의 fault-around와 readahead.
+   ASYNC는 readahead가 매핑하지 않고 둔 async 표시 페이지에서 난 폴트인지 */
+void vma_readahead(struct supplemental_page_table *spt, void *upage, bool async)
+{
+	struct vma *vma = vma_find(spt, upage);
+	size_t idx, start, end, marker;
+
+	if (vma == NULL || vma->type != VM_FILE)
+		return;
+	idx = (upage - vma->start) / PGSIZE;
+
+	if (fault_around_pages > 1)
+		vma_fault_around(spt, vma, upage);
+
+	if (async)
+	{
+		/* 표시 페이지에 닿음 = 순차로 읽는 중, 지난 창 바로 뒤부터 다음 창 */
+		start = vma->ra_next;
+		ra_async_cnt++;
+	}
+	else if (idx == vma->ra_prev + 1 || idx == vma->ra_next)
+	{
+		/* 순차 (처음 폴트가 페이지 0이어도 ra_prev가 -1이라 순차로 봄) */
+		start = idx + 1;
+		ra_sync_cnt++;
+	}
+	else
+	{
+		vma->ra_window /= 2;
+		vma->ra_prev = idx;
+		ra_random_cnt++;
+		return;
+	}
+
+	vma->ra_window = ra_grow(vma->ra_window);
+	vma->ra_async = vma->ra_window / 2;
+	vma->ra_prev = idx;
+
+	end = start + vma->ra_window;
+	if (end > (size_t)(vma->end - vma->start) / PGSIZE)
+		end = (vma->end - vma->start) / PGSIZE;
+	marker = end - vma->ra_async;
+	vma->ra_next = end;
+
+	for (size_t i = start; i < end; i++)
+	{
+		void *va = vma->start + i * PGSIZE;
+		struct lazy_load_arg arg;
+		struct page *page;
+
+		if (spt_find_page(spt, va) != NULL)
+			continue;
+
+		page = vma_new_page(spt, vma, va, &arg);
+		if (page == NULL)
+			break;
+		if (vm_map_cached_page(page))
+			continue;
+		if (!vm_prefetch_page(page, i != marker))
+		{
+			/* 남는 프레임이 없음: 다른 페이지를 퇴거시키면서까지 읽지는 않는다 */
+			spt_remove_page(spt, page);
+			vma->ra_next = i;
+			break;
+		}
+		ra_page_cnt++;
+	}
+}
+
+/* NOTE: [Improve] fault-around 통계 출력 */
+void vma_print_stats(void)
+{
+	printf("Fault-around: %u pages window, %lld faults, %lld hits, %lld misses\n",
+		   fault_around_pages, fault_around_cnt, fault_around_hit, fault_around_miss);
+	printf("Readahead: %lld sync windows, %lld async windows, %lld random faults, %lld pages read\n",
+		   ra_sync_cnt, ra_async_cnt, ra_random_cnt, ra_page_cnt);
+}
+
+/* NOTE: [Improve] VMA 범위의 페이지를 모두 해제하고 (수정된 파일 페이지는 기록) VMA를 지움 */
+void vma_unmap(struct supplemental_page_table *spt, struct vma *vma)
+{
+	spt_remove_range(spt, vma->start, vma->end);
+	if (spt->vma_hint == vma)
+		spt->vma_hint = NULL;
+	list_remove(&vma->elem);
+	file_close(vma->file);
+	free(vma);
+}
+
+/* NOTE: [Improve] fork: SRC의 VMA를 DST에 그대로 복사 (파일은 자식이 따로 다시 연다) */
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&src->vmas); e != list_end(&src->vmas); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (!vma_map(dst, vma->start, vma->end - vma->start, vma->file, vma->ofs,
+					 vma->read_bytes, vma->type, vma->writable, vma->mmap))
+			return false;
+	}
+	return true;
+}
+
+/* NOTE: [Improve] exec/exit: 모든 VMA를 범위 단위로 해제 */
+void vma_kill(struct supplemental_page_table *spt)
+{
+	while (!list_empty(&spt->vmas))
+		vma_unmap(spt, list_entry(list_front(&spt->vmas), struct vma, elem));
+}